@@ -0,0 +1,95 @@
+/**
+ * @file allocation.cc
+ * @author Daniel Panero 100%, Andrea Diez 0%
+ * @version 0.1
+ * @date 2022-05-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "allocation.h"
+
+static std::atomic<unsigned long long> allocation_count(0);
+
+unsigned long long Allocation::get_count()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+/** We replace the global operator new / delete: all the others versions (new[],
+ * nothrow, sized delete...) call these ones by default */
+void *operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    void *pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+
+void operator delete(void *pointer, std::size_t /*size*/) noexcept
+{
+    std::free(pointer);
+}
+
+// ====================================================================================
+// Pool
+
+// Number of blocks allocated at once when the pool is empty
+static constexpr std::size_t blocks_per_chunk(64);
+
+Allocation::Pool::Pool(std::size_t size)
+{
+    /* Every block must be able to hold the link of the free list, and its size a
+     * multiple of the strictest alignment, so that all the blocks of a chunk are
+     * aligned */
+    constexpr std::size_t alignment = alignof(std::max_align_t);
+
+    block_size = std::max(size, sizeof(FreeBlock));
+    block_size = (block_size + alignment - 1) / alignment * alignment;
+}
+
+void *Allocation::Pool::allocate()
+{
+    if (free_blocks == nullptr)
+    {
+        grow();
+    }
+
+    auto *block = free_blocks;
+    free_blocks = block->next;
+
+    return block;
+}
+
+void Allocation::Pool::deallocate(void *block)
+{
+    auto *free_block = static_cast<FreeBlock *>(block);
+    free_block->next = free_blocks;
+    free_blocks = free_block;
+}
+
+void Allocation::Pool::grow()
+{
+    auto *chunk = static_cast<char *>(::operator new(block_size * blocks_per_chunk));
+    chunks.push_back(chunk);
+
+    // The blocks are linked in order, so that they are handed out in order too
+    for (std::size_t i(blocks_per_chunk); i > 0; i--)
+    {
+        deallocate(chunk + (i - 1) * block_size);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+/**
+ * @file allocation.h
+ * @author Daniel Panero, Andrea Diez
+ * @brief Counts the heap allocations done by the program, it is used for checking that
+ * a step of the simulation doesn't allocate memory for each ant. It also provides the
+ * pools from which the ants and the foods are allocated
+ * @version 0.1
+ * @date 2022-05-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef ALLOCATION_H
+#define ALLOCATION_H
+
+#include <cstddef>
+#include <vector>
+
+namespace Allocation
+{
+    /**
+     * @brief Returns the number of heap allocations (operator new) done since the
+     * start of the program
+     *
+     * @return unsigned long long
+     */
+    unsigned long long get_count();
+
+    /**
+     * @brief Free list of blocks of the same size. The blocks are carved out of chunks
+     * allocated with the global operator new, which are never given back: once the
+     * pool has grown to the peak number of blocks alive, allocating and freeing a
+     * block doesn't touch the global allocator anymore
+     *
+     */
+    class Pool
+    {
+    public:
+        explicit Pool(std::size_t size);
+
+        Pool(Pool const &) = delete;
+        Pool &operator=(Pool const &) = delete;
+
+        /**
+         * @brief Returns a block of the size given to the constructor
+         *
+         * @return void*
+         */
+        void *allocate();
+        void deallocate(void *block);
+
+    private:
+        struct FreeBlock
+        {
+            FreeBlock *next;
+        };
+
+        void grow();
+
+        std::size_t block_size;
+        FreeBlock *free_blocks = nullptr;
+
+        // Only kept so that the chunks remain reachable
+        std::vector<void *> chunks;
+    };
+
+    /**
+     * @brief Returns the pool shared by all the instances of @p T
+     *
+     * @tparam T
+     * @return Pool&
+     */
+    template <typename T> Pool &get_pool()
+    {
+        static Pool pool(sizeof(T));
+        return pool;
+    }
+
+    /**
+     * @brief Base class that makes new / delete of @p T use \b get_pool<T>. An
+     * instance of a class derived from @p T (hence bigger) falls back to the global
+     * operator new
+     *
+     * @tparam T
+     */
+    template <typename T> class Pooled
+    {
+    public:
+        static void *operator new(std::size_t size)
+        {
+            if (size != sizeof(T))
+            {
+                return ::operator new(size);
+            }
+
+            return get_pool<T>().allocate();
+        }
+
+        static void operator delete(void *pointer, std::size_t size)
+        {
+            if (size != sizeof(T))
+            {
+                ::operator delete(pointer);
+                return;
+            }
+
+            get_pool<T>().deallocate(pointer);
+        }
+    };
+} // namespace Allocation
+
+#endif
@@ -10,50 +10,72 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <random>
-#include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 
+#include "config.h"
 #include "element.h"
 #include "message.h"
+#include "snapshot.h"
 #include "squarecell.h"
 
 #include "anthill.h"
 
-using std::bind;
-using std::function;
-using std::istringstream;
-using std::move;
-using std::remove;
 using std::string;
+using std::string_view;
 using std::unique_ptr;
 using std::vector;
 
 using Squarecell::Square;
 
+thread_local vector<Anthill::IndexedAnt> Anthill::indexed_ants;
+thread_local Squarecell::BucketGrid Anthill::ant_buckets;
+thread_local vector<unsigned int> Anthill::nearby_ants;
+
+/* Grid as of the beginning of the last call of plan_moves, and the copy of it on which
+ * each thread searches, refreshed when it takes its first search of a new call */
+static Squarecell::Grid search_snapshot;
+static unsigned long long search_call(0);
+static thread_local Squarecell::Grid search_grid;
+static thread_local unsigned long long search_grid_call(0);
+
 // ====================================================================================
 // Initialization - Misc
 
 Anthill::Anthill(unsigned int x, unsigned int y, unsigned int side, unsigned int xg,
-                 unsigned int yg, double n_food, unsigned int n_collectors,
-                 unsigned int n_defensors, unsigned int n_predators,
-                 unsigned int color_index)
+                 unsigned int yg, double n_food, unsigned int color_index)
     : Element{x, y, side, false, color_index}, n_food(n_food),
-      generator(new Generator(xg, yg, 0, color_index))
+      generator(new Generator(xg, yg, color_index))
 {
     Squarecell::test_square(*this);
+}
+
+Anthill::~Anthill()
+{
+    // The ants alive are removed from the grid after the dead ones
+    for (auto *ants : {&predators, &defensors, &collectors})
+    {
+        for (size_t i(0); i < ants->size(); i++)
+        {
+            if (ants->alive[i])
+            {
+                add_dead_ant(*ants, i);
+            }
+        }
+    }
 
-    // We preallocate the vectors, so when get_number_of... is called it return the
-    // right size
-    collectors.resize(n_collectors);
-    defensors.resize(n_defensors);
-    predators.resize(n_predators);
+    clear_dead_ants();
 }
 
-Anthill::~Anthill() { undraw(); }
+void Anthill::seed_random(uint64_t seed, uint64_t stream)
+{
+    random_num = Rng(seed, stream);
+}
 
 void Anthill::test_if_generator_defensors_perimeter(unsigned int index)
 {
@@ -64,9 +86,9 @@ void Anthill::test_if_generator_defensors_perimeter(unsigned int index)
             generator_square.x, generator_square.y, index));
     }
 
-    for (auto &defensor : defensors)
+    for (size_t i(0); i < defensors.size(); i++)
     {
-        auto defensor_square = defensor->get_as_square();
+        auto defensor_square = defensors.get_square(i);
         if (!Squarecell::test_if_completely_confined(defensor_square, *this))
         {
             throw std::invalid_argument(message::defensor_not_within_home(
@@ -75,31 +97,20 @@ void Anthill::test_if_generator_defensors_perimeter(unsigned int index)
     }
 }
 
-void Anthill::set_collectors(vector<unique_ptr<Collector>> &collectors)
-{
-    this->collectors = move(collectors);
-}
-void Anthill::set_defensors(vector<unique_ptr<Defensor>> &defensors)
-{
-    this->defensors = move(defensors);
-}
-void Anthill::set_predators(vector<unique_ptr<Predator>> &predators)
-{
-    this->predators = move(predators);
-}
-
-unsigned int Anthill::get_number_of_collectors() const { return collectors.size(); };
-unsigned int Anthill::get_number_of_defensors() const { return defensors.size(); };
-unsigned int Anthill::get_number_of_predators() const { return predators.size(); };
+unsigned int Anthill::get_number_of_collectors() const { return collectors.count(); };
+unsigned int Anthill::get_number_of_defensors() const { return defensors.count(); };
+unsigned int Anthill::get_number_of_predators() const { return predators.count(); };
 double Anthill::get_number_of_food() const { return n_food; }
 
-void Anthill::draw()
+void Anthill::draw(Graphic::Frame &frame)
 {
-    Squarecell::draw_only_border(*this, get_color_index());
-    generator->draw();
-}
+    Squarecell::draw_only_border(frame, *this, get_color_index());
+    generator->draw(frame);
 
-void Anthill::undraw() { Squarecell::undraw_thick_border_square(*this); }
+    Collector::draw(frame, collectors, get_color_index());
+    Defensor::draw(frame, defensors, get_color_index());
+    Predator::draw(frame, predators, get_color_index());
+}
 
 string Anthill::get_as_string()
 {
@@ -111,19 +122,29 @@ string Anthill::get_as_string()
                  to_string(get_number_of_defensors()) + " " +
                  to_string(get_number_of_predators()) + "\n";
 
-    for (auto const &collector : collectors)
+    // The dead ants are only flagged until the end of the step of the anthill
+    for (size_t i(0); i < collectors.size(); i++)
     {
-        tmp += collector->get_as_string() + "\n";
+        if (collectors.alive[i])
+        {
+            tmp += Collector::get_as_string(collectors, i) + "\n";
+        }
     }
 
-    for (auto const &defensor : defensors)
+    for (size_t i(0); i < defensors.size(); i++)
     {
-        tmp += defensor->get_as_string() + "\n";
+        if (defensors.alive[i])
+        {
+            tmp += defensors.get_as_string(i) + "\n";
+        }
     }
 
-    for (auto const &predator : predators)
+    for (size_t i(0); i < predators.size(); i++)
     {
-        tmp += predator->get_as_string() + "\n";
+        if (predators.alive[i])
+        {
+            tmp += predators.get_as_string(i) + "\n";
+        }
     }
 
     return tmp;
@@ -132,18 +153,19 @@ string Anthill::get_as_string()
 // ====================================================================================
 // Simulation
 
-bool Anthill::step(vector<unique_ptr<Food>> &foods,
-                   vector<unique_ptr<Anthill>> &anthills)
+bool Anthill::step(FoodSet &foods, vector<unique_ptr<Anthill>> &anthills,
+                   ThreadPool *pool)
 {
-    undraw();
-
     try_to_expand(anthills);
 
     if (!(generator->step(*this) && reduce_food()))
     {
-        for (auto &collector : collectors)
+        for (size_t i(0); i < collectors.size(); i++)
         {
-            collector->drop_food(foods);
+            if (collectors.alive[i])
+            {
+                Collector::drop_food(collectors, i, foods);
+            }
         }
 
         return false;
@@ -151,215 +173,705 @@ bool Anthill::step(vector<unique_ptr<Food>> &foods,
 
     generate_new_ants();
 
-    update_collectors(foods);
-    update_defensors(anthills);
-    update_predators(anthills);
+    update_collectors(foods, pool);
+
+    index_other_ants(anthills);
+    update_defensors(pool);
+    update_predators(pool);
 
-    draw();
+    store_positions();
 
     return true;
 }
 
-void Anthill::update_collectors(vector<unique_ptr<Food>> &foods)
+bool Anthill::plan(FoodSet &foods, vector<unique_ptr<Anthill>> &anthills)
+{
+    planning = true;
+    planned_kills.clear();
+    planned_drops.clear();
+
+    Squarecell::copy_grid(planned_grid);
+    Squarecell::GridScope scope(planned_grid);
+
+    previous_generator = generator->get_as_square();
+    record_previous(collectors, previous_collectors);
+    record_previous(defensors, previous_defensors);
+    record_previous(predators, previous_predators);
+
+    collector_plans.assign(collectors.size(), CollectorPlan());
+
+    bool alive = generator->step(*this) && reduce_food();
+    if (alive)
+    {
+        // The anthills already plan on several threads
+        update_collectors(foods, nullptr);
+
+        index_other_ants(anthills);
+        update_defensors(nullptr);
+        update_predators(nullptr);
+    }
+
+    planning = false;
+    return alive;
+}
+
+void Anthill::commit_kills()
+{
+    for (auto const &ant : planned_kills)
+    {
+        kill(ant);
+    }
+}
+
+void Anthill::commit(FoodSet &foods, bool alive)
+{
+    if (!alive)
+    {
+        generator->go_back(previous_generator);
+        for (size_t i(0); i < collectors.size(); i++)
+        {
+            if (collectors.alive[i])
+            {
+                Collector::drop_food(collectors, i, foods);
+            }
+        }
+
+        return;
+    }
+
+    generator->commit_move(previous_generator);
+    commit_collectors(foods);
+    commit_moves(defensors, previous_defensors);
+    commit_moves(predators, previous_predators);
+
+    // The dead collectors haven't moved, they are still in the grid
+    for (auto collector : planned_drops)
+    {
+        Collector::drop_food(collectors, collector, foods);
+    }
+
+    generate_new_ants();
+
+    store_positions();
+}
+
+void Anthill::record_previous(AntColumns const &ants, vector<Previous> &previous)
 {
-    for (auto &collector : collectors)
+    previous.clear();
+    for (size_t i(0); i < ants.size(); i++)
     {
-        if (!collector->step())
+        if (ants.alive[i])
         {
-            collector->drop_food(foods);
+            previous.push_back({i, ants.get_square(i)});
+        }
+    }
+}
 
-            dead_ants.push_back(move(collector));
+void Anthill::commit_moves(AntColumns &ants, vector<Previous> const &previous)
+{
+    for (auto const &entry : previous)
+    {
+        if (ants.alive[entry.column])
+        {
+            ants.commit_move(entry.column, entry.square);
+        }
+    }
+}
+
+void Anthill::commit_collectors(FoodSet &foods)
+{
+    for (auto const &entry : previous_collectors)
+    {
+        auto i = entry.column;
+        if (!collectors.alive[i])
+        {
             continue;
         }
 
-        if (collector->get_state() == EMPTY)
+        auto const &plan = collector_plans[i];
+        if (plan.food.index != SlotHandle::invalid)
         {
-            size_t target = 0;
-            if (collector->find_target_food(foods, target))
-            {
-                if (collector->search_food(foods.at(target)))
-                {
-                    std::swap(foods.at(target), foods.back());
-                    foods.pop_back();
-                };
-            }
-            else
-            {
-                collector->go_outside(*this);
-            }
+            Collector::commit_take(collectors, i, foods, plan.food, entry.square);
         }
-        else
+        else if (plan.delivery)
         {
-            if (collector->return_to_anthill(*this))
+            if (Collector::commit_delivery(collectors, i, entry.square))
             {
                 n_food += val_food;
             }
         }
+        else
+        {
+            collectors.commit_move(i, entry.square);
+        }
     }
+}
 
-    collectors.erase(remove(collectors.begin(), collectors.end(), nullptr),
-                     collectors.end());
+void Anthill::compute_home_field()
+{
+    bool loaded(false);
+    for (size_t i(0); i < collectors.size(); i++)
+    {
+        if (collectors.alive[i] && collectors.state[i] == LOADED)
+        {
+            Squarecell::remove_square(collectors.get_square(i));
+            loaded = true;
+        }
+    }
+
+    if (!loaded)
+    {
+        return;
+    }
+
+    // A collector reaches the anthill as soon as it touches its border
+    const unsigned int margin(sizeC + 1);
+    Square model{0, 0, sizeC, true};
+    Square region{x > margin ? x - margin : 0, y > margin ? y - margin : 0,
+                  side + 2 * margin, false};
+
+    home_field.compute<Collector::Moves>(
+        model, *this, region, [](Square const &origin, Square const &anthill)
+        { return Collector::test_if_reached_anthill(origin, anthill); });
+
+    for (size_t i(0); i < collectors.size(); i++)
+    {
+        if (collectors.alive[i] && collectors.state[i] == LOADED)
+        {
+            Collector::add_to_grid(collectors.get_square(i));
+        }
+    }
 }
 
-void Anthill::update_defensors(vector<unique_ptr<Anthill>> &anthills)
+void Anthill::compute_food_field(FoodSet &foods)
 {
-    for (auto &defensor : defensors)
+    for (size_t i(0); i < collectors.size(); i++)
     {
-        if (!defensor->step(*this))
+        if (collectors.alive[i] && collectors.state[i] == EMPTY)
         {
-            dead_ants.push_back(move(defensor));
-            continue;
+            Squarecell::remove_square(collectors.get_square(i));
         }
+    }
+
+    /* Foods are removed too: a position superposing a food is a goal and the search
+     * never goes further than a goal */
+    food_goals.clear();
+    for (auto &food : foods)
+    {
+        food->remove_from_grid();
 
-        for (auto const &anthill : anthills)
+        auto food_square = food->get_as_square();
+        for (int dx(-1); dx <= 1; dx++)
         {
-            if (anthill && anthill.get() != this)
+            for (int dy(-1); dy <= 1; dy++)
             {
-                auto test = bind(&Defensor::test_if_contact_collector,
-                                 std::ref(*defensor), std::placeholders::_1);
-
-                anthill->mark_collectors_as_dead(test);
+                food_goals.push_back(
+                    {food_square.x + dx, food_square.y + dy, sizeC, true});
             }
         }
     }
 
-    defensors.erase(remove(defensors.begin(), defensors.end(), nullptr),
-                    defensors.end());
+    food_field.compute<Collector::Moves>({0, 0, sizeC, true}, food_goals);
+
+    for (auto &food : foods)
+    {
+        food->add_to_grid();
+    }
+
+    for (size_t i(0); i < collectors.size(); i++)
+    {
+        if (collectors.alive[i] && collectors.state[i] == EMPTY)
+        {
+            Collector::add_to_grid(collectors.get_square(i));
+        }
+    }
 }
 
-void Anthill::update_predators(vector<unique_ptr<Anthill>> &anthills)
+void Anthill::update_collectors(FoodSet &foods, ThreadPool *pool)
 {
-    for (auto &predator : predators)
+    compute_home_field();
+
+    // The food field is only computed when needed and again when a food is taken
+    bool food_field_outdated(true);
+
+    collectors.increase_age();
+
+    /* Only the empty collectors that can't reach any food search (the others follow
+     * a field). They are guessed with the food field of the last step, a wrong guess
+     * only costs a search done for nothing or done again */
+    planned_moves.clear();
+    if (pool)
     {
-        if (!predator->step())
+        search_origins.assign(collectors.size(), Square{});
+        for (size_t i(0); i < collectors.size(); i++)
         {
-            dead_ants.push_back(move(predator));
-            continue;
+            auto collector = collectors.get_square(i);
+            if (collectors.alive[i] && collectors.state[i] == EMPTY &&
+                !Collector::can_reach_food(collector, food_field))
+            {
+                search_origins[i] = collector;
+            }
         }
 
-        vector<Square> targets;
-        if (attack_near_ant_get_attackable_ants(anthills, targets, predator))
+        plan_moves(*pool, [this](Square const &origin)
+                   { return Collector::search_outside(origin, *this); });
+    }
+
+    for (size_t i(0); i < collectors.size(); i++)
+    {
+        if (!collectors.alive[i])
         {
-            dead_ants.push_back(move(predator));
             continue;
         }
 
-        if (targets.empty())
+        if (collectors.test_if_too_old(i))
         {
-            predator->remain_inside(*this);
+            if (collectors.state[i] == LOADED)
+            {
+                food_field_outdated = true;
+            }
+            drop_food(foods, i);
+
+            add_dead_ant(collectors, i);
             continue;
         }
 
-        predator->move_toward_nearest_ant(targets);
+        if (collectors.state[i] == EMPTY)
+        {
+            if (food_field_outdated)
+            {
+                compute_food_field(foods);
+                food_field_outdated = false;
+            }
+
+            SlotHandle target;
+            if (!Collector::can_reach_food(collectors.get_square(i), food_field))
+            {
+                Collector::go_outside(collectors, i, *this, get_planned_move(i));
+            }
+            else if (Collector::search_food(collectors, i, foods, food_field, target))
+            {
+                take_food(foods, i, target);
+
+                food_field_outdated = true;
+            }
+        }
+        else
+        {
+            if (Collector::return_to_anthill(collectors, i, *this, home_field))
+            {
+                deliver_food(i);
+            }
+        }
     }
+}
 
-    predators.erase(remove(predators.begin(), predators.end(), nullptr),
-                    predators.end());
+void Anthill::take_food(FoodSet &foods, size_t collector, SlotHandle target)
+{
+    /* The food stays in the set until the commit, but the collector covers it in the
+     * planned grid, so that no other position superposing it is a goal of the food
+     * field anymore */
+    if (planning)
+    {
+        collector_plans[collector].food = target;
+        return;
+    }
+
+    foods.erase(target);
 }
 
-bool Anthill::attack_near_ant_get_attackable_ants(
-    vector<unique_ptr<Anthill>> &anthills, vector<Square> &targets,
-    unique_ptr<Predator> &predator)
+void Anthill::drop_food(FoodSet &foods, size_t collector)
 {
-    auto anthill_square = get_as_square();
-    auto predator_square = predator->get_as_square();
+    if (planning)
+    {
+        if (collectors.state[collector] == LOADED)
+        {
+            planned_drops.push_back(collector);
+        }
+        return;
+    }
 
-    auto filter =
-        bind(&Predator::filter_ants, state, anthill_square, std::placeholders::_1);
-    auto test =
-        bind(&Predator::test_if_reached_ant, predator_square, std::placeholders::_1);
+    Collector::drop_food(collectors, collector, foods);
+}
+
+void Anthill::deliver_food(size_t collector)
+{
+    if (planning)
+    {
+        collector_plans[collector].delivery = true;
+        return;
+    }
+
+    n_food += val_food;
+}
+
+void Anthill::store_positions()
+{
+    collectors.erase_dead();
+    defensors.erase_dead();
+    predators.erase_dead();
+
+    collector_positions.assign(collectors);
+    predator_positions.assign(predators);
+}
+
+void Anthill::add_dead_ant(AntColumns &ants, size_t i)
+{
+    dead_ants.push_back({ants.get_square(i), ants.state[i] == LOADED});
+    ants.set_dead(i);
+}
+
+void Anthill::clear_dead_ants()
+{
+    for (auto const &ant : dead_ants)
+    {
+        Squarecell::remove_square(ant.square);
+
+        /**
+         * If it was carrying some food, we have to add it back to the simulation. This
+         * was automatically done by the anthill which has direct access to the food,
+         * but since we are clearing the grid, this would eliminate the food. Therefore
+         * we have to manually set the position as true
+         *
+         */
+        if (ant.loaded)
+        {
+            Square food{ant.square.x, ant.square.y, 1, true};
+
+            Squarecell::add_square(food);
+        }
+    }
+
+    dead_ants.clear();
+}
+
+void Anthill::index_other_ants(vector<unique_ptr<Anthill>> &anthills)
+{
+    indexed_ants.clear();
+    ant_buckets.clear();
 
-    bool dead = false;
     for (auto const &anthill : anthills)
     {
-        if (anthill && anthill.get() != this)
+        if (!anthill || anthill.get() == this)
+        {
+            continue;
+        }
+
+        // The ants killed since the positions were stored are skipped
+        auto const &collectors = anthill->collector_positions;
+        for (unsigned int i(0); i < collectors.size(); i++)
         {
-            anthill->get_attackable_ants(filter, targets);
+            if (!collectors.alive[i])
+            {
+                continue;
+            }
 
-            anthill->mark_collectors_as_dead(test);
-            if (anthill->mark_predators_as_dead(test))
+            ant_buckets.insert({collectors.x[i], collectors.y[i], sizeC, true},
+                               indexed_ants.size());
+            indexed_ants.push_back({anthill.get(), false, i, false});
+        }
+
+        auto const &predators = anthill->predator_positions;
+        for (unsigned int i(0); i < predators.size(); i++)
+        {
+            if (!predators.alive[i])
             {
-                dead = true;
-                break;
+                continue;
             }
+
+            ant_buckets.insert({predators.x[i], predators.y[i], sizeP, true},
+                               indexed_ants.size());
+            indexed_ants.push_back({anthill.get(), true, i, false});
         }
     }
+}
+
+bool Anthill::get_indexed_ant(unsigned int id, Square &square)
+{
+    auto const &entry = indexed_ants[id];
+    auto const &positions = entry.predator ? entry.anthill->predator_positions
+                                           : entry.anthill->collector_positions;
 
-    return dead;
+    if (entry.killed || !positions.alive[entry.column])
+    {
+        return false;
+    }
+
+    square = {positions.x[entry.column], positions.y[entry.column],
+              entry.predator ? sizeP : sizeC, true};
+    return true;
 }
 
-bool Anthill::get_attackable_ants(const function<bool(Square &)> &test,
-                                  vector<Square> &targets)
+void Anthill::kill_indexed_ant(unsigned int id)
 {
-    bool found = false;
+    auto &entry = indexed_ants[id];
+    entry.killed = true;
 
-    for (auto const &collector : collectors)
+    if (planning)
     {
-        if (test(*collector))
+        planned_kills.push_back(entry);
+        return;
+    }
+
+    kill(entry);
+}
+
+void Anthill::kill(IndexedAnt const &ant)
+{
+    auto &anthill = *ant.anthill;
+    auto &ants = ant.predator ? anthill.predators : anthill.collectors;
+    auto &positions =
+        ant.predator ? anthill.predator_positions : anthill.collector_positions;
+
+    // The columns keep the indices of the positions until the end of the next step
+    if (!ants.alive[ant.column])
+    {
+        return;
+    }
+
+    /* While planning, the anthill of the ant may have moved it, it goes back to
+     * the stored position, which is still the one in the grid */
+    ants.x[ant.column] = positions.x[ant.column];
+    ants.y[ant.column] = positions.y[ant.column];
+    positions.alive[ant.column] = 0;
+
+    anthill.add_dead_ant(ants, ant.column);
+}
+
+void Anthill::update_defensors(ThreadPool *pool)
+{
+    defensors.increase_age();
+
+    planned_moves.clear();
+    if (pool)
+    {
+        search_origins.assign(defensors.size(), Square{});
+        for (size_t i(0); i < defensors.size(); i++)
         {
-            targets.push_back(*collector);
+            if (defensors.alive[i])
+            {
+                search_origins[i] = defensors.get_square(i);
+            }
         }
+
+        plan_moves(*pool, [this](Square const &origin)
+                   { return Defensor::search_border(origin, *this); });
     }
 
-    for (auto const &predator : predators)
+    for (size_t i(0); i < defensors.size(); i++)
     {
-        if (test(*predator))
+        if (!defensors.alive[i])
         {
-            targets.push_back(*predator);
+            continue;
         }
-    }
 
-    return found;
+        auto previous = defensors.get_square(i);
+        if (defensors.test_if_too_old(i) ||
+            !Defensor::step(defensors, i, *this, get_planned_move(i)))
+        {
+            /* A defensor can die after having moved out of the anthill, but while
+             * planning the shared grid still holds its previous position */
+            if (planning)
+            {
+                defensors.set_position(i, previous);
+            }
+            add_dead_ant(defensors, i);
+            continue;
+        }
+
+        // A collector touching the defensor is at most one cell away from it
+        auto defensor = defensors.get_square(i);
+        nearby_ants.clear();
+        ant_buckets.query(defensor, 1, nearby_ants);
+
+        for (auto id : nearby_ants)
+        {
+            Square collector;
+            if (!indexed_ants[id].predator && get_indexed_ant(id, collector) &&
+                Defensor::test_if_contact_collector(defensor, collector))
+            {
+                kill_indexed_ant(id);
+            }
+        }
+    }
 }
 
-bool Anthill::mark_collectors_as_dead(const function<bool(Square &)> &test)
+void Anthill::update_predators(ThreadPool *pool)
 {
-    bool found = false;
+    // Shared by all the predators, so that it is allocated at most once per step
+    vector<Square> targets;
 
-    for (auto &collector : collectors)
+    /* The targets only change when an ant is killed: the searches are planned with the
+     * targets of the beginning of the step and kept as long as they are the same */
+    predators.increase_age();
+
+    planned_moves.clear();
+    planned_targets.clear();
+    if (pool)
     {
-        if (collector && test(*collector))
+        get_attackable_ants(planned_targets);
+
+        search_origins.assign(predators.size(), Square{});
+        for (size_t i(0); i < predators.size(); i++)
         {
-            dead_ants.push_back(move(collector));
-            found = true;
+            if (predators.alive[i])
+            {
+                search_origins[i] = predators.get_square(i);
+            }
         }
+
+        plan_moves(*pool,
+                   [this](Square const &origin)
+                   {
+                       return planned_targets.empty()
+                                  ? Predator::search_inside(origin, *this)
+                                  : Predator::search_nearest_ant(origin,
+                                                                 planned_targets);
+                   });
     }
 
-    collectors.erase(remove(collectors.begin(), collectors.end(), nullptr),
-                     collectors.end());
+    auto same_square = [](Square const &a, Square const &b)
+    { return a.x == b.x && a.y == b.y && a.side == b.side; };
+
+    for (size_t i(0); i < predators.size(); i++)
+    {
+        if (!predators.alive[i])
+        {
+            continue;
+        }
+
+        if (predators.test_if_too_old(i))
+        {
+            add_dead_ant(predators, i);
+            continue;
+        }
+
+        targets.clear();
+        get_attackable_ants(targets);
+        if (attack_near_ants(predators.get_square(i)))
+        {
+            add_dead_ant(predators, i);
+            continue;
+        }
 
-    return found;
+        auto planned = get_planned_move(i);
+        if (planned && !std::equal(targets.begin(), targets.end(),
+                                   planned_targets.begin(), planned_targets.end(),
+                                   same_square))
+        {
+            planned = nullptr;
+        }
+
+        if (targets.empty())
+        {
+            Predator::remain_inside(predators, i, *this, planned);
+            continue;
+        }
+
+        Predator::move_toward_nearest_ant(predators, i, targets, planned);
+    }
 }
 
-bool Anthill::mark_predators_as_dead(const function<bool(Square &)> &test)
+void Anthill::get_attackable_ants(vector<Square> &targets)
 {
-    bool found = false;
+    auto anthill_square = get_as_square();
+
+    // When the anthill is free, only the ants inside of it can be attacked
+    nearby_ants.clear();
+    if (state == CONSTRAINED)
+    {
+        for (unsigned int id(0); id < indexed_ants.size(); id++)
+        {
+            nearby_ants.push_back(id);
+        }
+    }
+    else
+    {
+        ant_buckets.query(anthill_square, 0, nearby_ants);
+    }
 
-    for (auto &predator : predators)
+    for (auto id : nearby_ants)
     {
-        if (predator && test(*predator))
+        Square ant;
+        if (get_indexed_ant(id, ant) &&
+            Predator::filter_ants(state, anthill_square, ant))
         {
-            dead_ants.push_back(move(predator));
-            found = true;
+            targets.push_back(ant);
         }
     }
+}
 
-    predators.erase(remove(predators.begin(), predators.end(), nullptr),
-                    predators.end());
+bool Anthill::attack_near_ants(Square const &predator_square)
+{
+    /* The ants are attacked anthill by anthill: if a predator of an anthill is
+     * reached, the predator dies after having attacked all the ants of that anthill
+     * it reaches, but before attacking the ones of the following anthills */
+    nearby_ants.clear();
+    ant_buckets.query(predator_square, 1, nearby_ants);
+
+    Anthill *killer = nullptr;
+    for (auto id : nearby_ants)
+    {
+        if (killer && indexed_ants[id].anthill != killer)
+        {
+            break;
+        }
 
-    return found;
+        Square ant;
+        if (get_indexed_ant(id, ant) &&
+            Predator::test_if_reached_ant(predator_square, ant))
+        {
+            kill_indexed_ant(id);
+            if (indexed_ants[id].predator)
+            {
+                killer = indexed_ants[id].anthill;
+            }
+        }
+    }
+
+    return killer != nullptr;
 }
 
-void Anthill::clear_dead_ants()
+template <typename Search>
+void Anthill::plan_moves(ThreadPool &pool, Search const &search)
 {
-    undraw();
+    Squarecell::copy_grid(search_snapshot);
+    search_call++;
+
+    planned_moves.assign(search_origins.size(), Square{});
+    pool.run(search_origins.size(),
+             [&](size_t i)
+             {
+                 auto const &origin = search_origins[i];
+                 if (origin.side == 0)
+                 {
+                     return;
+                 }
+
+                 if (search_grid_call != search_call)
+                 {
+                     search_grid = search_snapshot;
+                     search_grid_call = search_call;
+                 }
+                 Squarecell::GridScope scope(search_grid);
+
+                 Squarecell::remove_square(origin);
+                 planned_moves[i] = search(origin);
+                 Squarecell::add_square(origin);
+             });
+}
 
-    dead_ants.clear();
+Square const *Anthill::get_planned_move(size_t i) const
+{
+    if (i >= planned_moves.size() || planned_moves[i].side == 0)
+    {
+        return nullptr;
+    }
 
-    draw();
+    return &planned_moves[i];
 }
 
-unique_ptr<Anthill> Anthill::parse_line(string &line, unsigned int color_index)
+unique_ptr<Anthill> Anthill::parse(Config::File &file, unsigned int color_index)
 {
     unsigned int x(0);
     unsigned int y(0);
@@ -372,7 +884,7 @@ unique_ptr<Anthill> Anthill::parse_line(string &line, unsigned int color_index)
     unsigned int n_defensors(0);
     unsigned int n_predators(0);
 
-    istringstream stream(line);
+    Config::Line stream(file.next_line());
 
     stream >> x;
     stream >> y;
@@ -384,14 +896,29 @@ unique_ptr<Anthill> Anthill::parse_line(string &line, unsigned int color_index)
     stream >> n_defensors;
     stream >> n_predators;
 
-    return unique_ptr<Anthill>(new Anthill(x, y, side, xg, yg, n_food, n_collectors,
-                                           n_defensors, n_predators, color_index));
+    unique_ptr<Anthill> anthill(new Anthill(x, y, side, xg, yg, n_food, color_index));
+
+    parse_ants<Collector>(file, n_collectors, anthill->collectors);
+    parse_ants<Defensor>(file, n_defensors, anthill->defensors);
+    parse_ants<Predator>(file, n_predators, anthill->predators);
+    anthill->store_positions();
+
+    return anthill;
+}
+
+template <typename T>
+void Anthill::parse_ants(Config::File &file, unsigned int n, AntColumns &ants)
+{
+    for (unsigned int i(0); i < n; i++)
+    {
+        T::parse_line(file.next_line(), ants);
+    }
 }
 
 void Anthill::try_to_expand(vector<unique_ptr<Anthill>> &anthills)
 {
-    vector<int> xshift{0, 0, -1, -1};
-    vector<int> yshift{0, -1, -1, 0};
+    static const int xshift[]{0, 0, -1, -1};
+    static const int yshift[]{0, -1, -1, 0};
 
     Square origin{};
     bool successfull = false;
@@ -399,9 +926,9 @@ void Anthill::try_to_expand(vector<unique_ptr<Anthill>> &anthills)
     {
         origin = get_as_square();
         origin.side = calculate_side();
-        origin.x += xshift.at(i) *
+        origin.x += xshift[i] *
                     (origin.side > side ? origin.side - side : side - origin.side);
-        origin.y += yshift.at(i) *
+        origin.y += yshift[i] *
                     (origin.side > side ? origin.side - side : side - origin.side);
         if (Squarecell::test_square_without_message(origin))
         {
@@ -450,7 +977,6 @@ bool Anthill::test_superposition_with_other_anthills(
 void Anthill::generate_new_ants()
 {
     std::bernoulli_distribution b_distribution(std::min(1.0, n_food * birth_rate));
-    static std::default_random_engine random_num;
 
     if (!b_distribution(random_num))
     {
@@ -490,11 +1016,7 @@ void Anthill::create_collector()
     Square position{};
     if (find_suitable_position_for_ant(sizeC, position))
     {
-        unique_ptr<Collector> collector(
-            new Collector{position.x, position.y, 0, EMPTY, get_color_index()});
-        collector->draw();
-
-        collectors.push_back(move(collector));
+        Collector::insert(collectors, position.x, position.y, 0, EMPTY);
     }
 }
 
@@ -503,11 +1025,7 @@ void Anthill::create_defensor()
     Square position{};
     if (find_suitable_position_for_ant(sizeD, position))
     {
-        unique_ptr<Defensor> defensor(
-            new Defensor{position.x, position.y, 0, get_color_index()});
-        defensor->draw();
-
-        defensors.push_back(move(defensor));
+        Defensor::insert(defensors, position.x, position.y, 0);
     }
 }
 
@@ -516,11 +1034,7 @@ void Anthill::create_predator()
     Square position{};
     if (find_suitable_position_for_ant(sizeP, position))
     {
-        unique_ptr<Predator> predator(
-            new Predator{position.x, position.y, 0, get_color_index()});
-        predator->draw();
-
-        predators.push_back(move(predator));
+        Predator::insert(predators, position.x, position.y, 0);
     }
 }
 
@@ -563,4 +1077,83 @@ bool Anthill::find_suitable_position_for_ant(unsigned int side_ant, Square &posi
     }
 
     return false;
-}
\ No newline at end of file
+}
+
+void Anthill::write_snapshot(string &out)
+{
+    auto generator_square = generator->get_as_square();
+
+    SnapshotRecord record{};
+    record.x = x;
+    record.y = y;
+    record.side = side;
+    record.color_index = get_color_index();
+    record.state = state;
+    record.xg = generator_square.x;
+    record.yg = generator_square.y;
+    record.n_collectors = collectors.count();
+    record.n_defensors = defensors.count();
+    record.n_predators = predators.count();
+    record.n_food = n_food;
+    record.random_num = random_num;
+    Snapshot::write(out, record);
+
+    vector<AntRecord> ants;
+    for (auto const *columns : {&collectors, &defensors, &predators})
+    {
+        ants.clear();
+        for (size_t i(0); i < columns->size(); i++)
+        {
+            if (columns->alive[i])
+            {
+                ants.push_back({columns->x[i], columns->y[i], columns->age[i],
+                                columns->state[i]});
+            }
+        }
+        Snapshot::write_array(out, ants);
+    }
+}
+
+unique_ptr<Anthill> Anthill::read_snapshot(char const *&data, char const *end)
+{
+    SnapshotRecord record{};
+    Snapshot::read(data, end, record);
+    if (record.state > CONSTRAINED)
+    {
+        throw std::invalid_argument("invalid anthill state");
+    }
+
+    unique_ptr<Anthill> anthill(new Anthill(record.x, record.y, record.side, record.xg,
+                                            record.yg, record.n_food,
+                                            record.color_index));
+    anthill->state = static_cast<State_anthill>(record.state);
+    anthill->random_num = record.random_num;
+
+    vector<AntRecord> ants;
+    Snapshot::read_array(data, end, ants);
+    for (auto const &ant : ants)
+    {
+        if (ant.state > LOADED)
+        {
+            throw std::invalid_argument("invalid collector state");
+        }
+        Collector::insert(anthill->collectors, ant.x, ant.y, ant.age,
+                          static_cast<State_collector>(ant.state));
+    }
+
+    Snapshot::read_array(data, end, ants);
+    for (auto const &ant : ants)
+    {
+        Defensor::insert(anthill->defensors, ant.x, ant.y, ant.age);
+    }
+
+    Snapshot::read_array(data, end, ants);
+    for (auto const &ant : ants)
+    {
+        Predator::insert(anthill->predators, ant.x, ant.y, ant.age);
+    }
+
+    anthill->store_positions();
+
+    return anthill;
+}
@@ -11,17 +11,23 @@
 #ifndef ENTITIES_ANTHILL_H
 #define ENTITIES_ANTHILL_H
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "ants.h"
 #include "collector.h"
+#include "config.h"
 #include "constantes.h"
 #include "defensor.h"
 #include "element.h"
 #include "generator.h"
 #include "predator.h"
+#include "rng.h"
+#include "slotmap.h"
 #include "squarecell.h"
+#include "threadpool.h"
 
 class Anthill : public Element
 {
@@ -35,16 +41,11 @@ public:
      * @param xg position of generator in the x-axis
      * @param yg position of generator in the y-axis
      * @param n_food total number of foods
-     * @param n_collectors number of collectors
-     * @param n_defensors number of defensors
-     * @param n_predators number of predators
      * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) same as
      * graphic.h
      */
     Anthill(unsigned int x, unsigned int y, unsigned int side, unsigned int xg,
-            unsigned int yg, double n_food, unsigned int n_collectors,
-            unsigned int n_defensors, unsigned int n_predators,
-            unsigned int color_index);
+            unsigned int yg, double n_food, unsigned int color_index);
     ~Anthill() override;
 
     /**
@@ -55,44 +56,101 @@ public:
      */
     void test_if_generator_defensors_perimeter(unsigned int index);
 
-    void set_collectors(std::vector<std::unique_ptr<Collector>> &collectors);
-    void set_defensors(std::vector<std::unique_ptr<Defensor>> &defensor);
-    void set_predators(std::vector<std::unique_ptr<Predator>> &predator);
+    /**
+     * @brief Restarts the random numbers of the anthill (births) from the stream
+     * @p stream of @p seed
+     *
+     */
+    void seed_random(uint64_t seed, uint64_t stream);
 
     unsigned int get_number_of_collectors() const;
     unsigned int get_number_of_defensors() const;
     unsigned int get_number_of_predators() const;
     double get_number_of_food() const;
 
-    void draw() override;
-    void undraw() override;
+    void draw(Graphic::Frame &frame) override;
 
     std::string get_as_string() override;
 
-    bool step(std::vector<std::unique_ptr<Food>> &foods,
-              std::vector<std::unique_ptr<Anthill>> &anthills);
+    /**
+     * @brief Advances the anthill by one step. With @p pool, the searches of the
+     * next positions of the ants are done in advance on the threads of @p pool,
+     * kind by kind, on a copy of the grid taken before the ants of that kind start
+     * moving (see \b plan_moves). The ants still move one after the other and each
+     * of them keeps its planned position only if it is free in the grid as it is
+     * when it moves, otherwise it searches again. The result doesn't depend on the
+     * number of threads of @p pool
+     *
+     * @param foods
+     * @param anthills
+     * @param pool
+     * @return false if the anthill dies
+     */
+    bool step(FoodSet &foods, std::vector<std::unique_ptr<Anthill>> &anthills,
+              ThreadPool *pool = nullptr);
+
+    /**
+     * @brief Grows the anthill if it doesn't superpose the other anthills, otherwise
+     * it becomes CONSTRAINED. It is the first part of \b step
+     *
+     * @param anthills
+     */
+    void try_to_expand(std::vector<std::unique_ptr<Anthill>> &anthills);
+
+    /**
+     * @brief First phase of a two-phase tick (see Simulation::set_threads): same as
+     * \b step after \b try_to_expand, but on a private copy of the grid taken at
+     * the beginning of the call, so that all the anthills can plan at the same time.
+     * Nothing shared with the other anthills is modified: the foods taken or dropped
+     * and the ants of the other anthills killed are only recorded, no ant is born
+     * and the shared grid still holds the positions before the plan
+     *
+     * @param foods only read
+     * @param anthills only read
+     * @return false if the anthill dies
+     */
+    bool plan(FoodSet &foods, std::vector<std::unique_ptr<Anthill>> &anthills);
+
+    /**
+     * @brief Second phase of a two-phase tick, done for all the anthills (in order)
+     * before \b commit: erases the ants killed by this anthill during \b plan, if
+     * they are still alive
+     *
+     */
+    void commit_kills();
+
+    /**
+     * @brief Last phase of a two-phase tick, done one anthill after the other in a
+     * fixed order: moves the ants in the shared grid to their planned positions
+     * unless an ant committed before has taken them (the ant stays where it was), same
+     * for the foods taken, then drops the foods of the dead collectors and gives birth
+     * to the new ants
+     *
+     * @param foods
+     * @param alive result of \b plan
+     */
+    void commit(FoodSet &foods, bool alive);
 
     /**
-     * @brief Called by others Anthills in order to find the nearest attackable Ant
-     * (Collector / Predator) in this Anthill that complies with the constraint \b test
+     * @brief Appends the binary snapshot of the anthill to @p out (see
+     * Simulation::save_snapshot): a fixed-size record with its square, generator,
+     * state, food and random numbers, then the records of its collectors, defensors
+     * and predators in their order of iteration
      *
-     * @param test
-     * @param[out] targets
-     * @return true if it has found one
+     * @param[out] out
      */
-    bool get_attackable_ants(const std::function<bool(Squarecell::Square &)> &test,
-                             std::vector<Squarecell::Square> &targets);
+    void write_snapshot(std::string &out);
 
     /**
-     * @brief Called by others Anthills in order to initiate an attack, return true if
-     * at least one ant was killed
+     * @brief Creates a new pointed instance of Anthill from the snapshot written by
+     * \b write_snapshot at @p data, and moves @p data after it
      *
-     * @param test function called for testing if the ant should be killed or not
-     * @return true if at least one ant was killed
+     * @param data
+     * @param end end of the snapshot
+     * @return std::unique_ptr<Anthill>
+     * @throw std::invalid_argument if the snapshot is truncated or not valid
      */
-    bool
-    mark_collectors_as_dead(const std::function<bool(Squarecell::Square &)> &test);
-    bool mark_predators_as_dead(const std::function<bool(Squarecell::Square &)> &test);
+    static std::unique_ptr<Anthill> read_snapshot(char const *&data, char const *end);
 
     /**
      * @brief Dumps all the dead ants, it clears the grid and the model
@@ -101,18 +159,19 @@ public:
     void clear_dead_ants();
 
     /**
-     * @brief Creates a new pointed instance Anthill from its string representation
+     * @brief Creates a new pointed instance Anthill from its string representation:
+     * the next line of @p file, followed by one line per collector, defensor and
+     * predator
      *
-     * @param line
+     * @param file
      * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) same as
      * graphic.h
      * @return std::unique_ptr<Anthill>
      */
-    static std::unique_ptr<Anthill> parse_line(std::string &line,
-                                               unsigned int color_index);
+    static std::unique_ptr<Anthill> parse(Config::File &file,
+                                          unsigned int color_index);
 
 private:
-    void try_to_expand(std::vector<std::unique_ptr<Anthill>> &anthills);
     bool test_superposition_with_other_anthills(
         std::vector<std::unique_ptr<Anthill>> &anthill,
         const Squarecell::Square &square);
@@ -134,24 +193,262 @@ private:
     bool find_suitable_position_for_ant(unsigned int side_ant,
                                         Squarecell::Square &position);
 
-    void update_collectors(std::vector<std::unique_ptr<Food>> &foods);
-    void update_defensors(std::vector<std::unique_ptr<Anthill>> &anthills);
-    void update_predators(std::vector<std::unique_ptr<Anthill>> &anthills);
+    /**
+     * @brief Computes \b home_field, the loaded collectors are removed from the grid
+     * during the computation as they are the ones who are going to move
+     *
+     */
+    void compute_home_field();
 
-    bool attack_near_ant_get_attackable_ants(
-        std::vector<std::unique_ptr<Anthill>> &anthills,
-        std::vector<Squarecell::Square> &targets, std::unique_ptr<Predator> &);
+    /**
+     * @brief Computes \b food_field from all the positions superposing a food, the
+     * empty collectors are removed from the grid during the computation. As the
+     * collectors only move diagonally, each of them only reaches the foods with the
+     * same parity
+     *
+     * @param foods
+     */
+    void compute_food_field(FoodSet &foods);
+
+    /**
+     * @brief Appends to @p ants the @p n ants of type T (Collector / Defensor /
+     * Predator) of the next lines of @p file
+     *
+     */
+    template <typename T>
+    static void parse_ants(Config::File &file, unsigned int n, AntColumns &ants);
+
+    /**
+     * @brief Erases the dead ants from the columns and copies the positions of the
+     * collectors / predators for the other anthills. It has to be called at the end
+     * of each step and each time new ones are added
+     *
+     */
+    void store_positions();
+
+    /**
+     * @brief Flags the @p i th ant of @p ants as dead and keeps it in the grid until
+     * \b clear_dead_ants
+     *
+     */
+    void add_dead_ant(AntColumns &ants, size_t i);
+
+    /**
+     * @brief Rebuilds the index from the positions of all the other anthills, whose
+     * ants don't move while this anthill steps
+     *
+     * @param anthills
+     */
+    void index_other_ants(std::vector<std::unique_ptr<Anthill>> &anthills);
+
+    void update_collectors(FoodSet &foods, ThreadPool *pool);
+    void update_defensors(ThreadPool *pool);
+    void update_predators(ThreadPool *pool);
+
+    /**
+     * @brief Appends to @p targets the ants of the other anthills that the
+     * predators can attack, the same for all of them
+     *
+     */
+    void get_attackable_ants(std::vector<Squarecell::Square> &targets);
+
+    /**
+     * @brief Kills the ants of the other anthills reached by the predator at
+     * @p predator_square
+     *
+     * @return true if the predator dies (it has reached a predator)
+     */
+    bool attack_near_ants(Squarecell::Square const &predator_square);
+
+    /**
+     * @brief Searches on @p pool the next position of each ant of \b search_origins
+     * (the ones with side 0 are skipped) and stores them in \b planned_moves. Each
+     * search runs on a copy of the grid taken at the beginning of the call, from which
+     * only the ant searching is removed. Each thread of @p pool copies the grid once
+     * per call
+     *
+     * @param pool
+     * @param search called as search(origin), returns the next position from origin
+     */
+    template <typename Search>
+    void plan_moves(ThreadPool &pool, Search const &search);
+
+    /**
+     * @brief Returns the position planned for the @p i th ant by \b plan_moves, or
+     * nullptr if there is none
+     *
+     */
+    Squarecell::Square const *get_planned_move(size_t i) const;
+
+    /**
+     * @brief Ant of another anthill, referenced by its entry in the collector /
+     * predator positions (and columns) of its anthill
+     *
+     */
+    struct IndexedAnt
+    {
+        Anthill *anthill;
+        bool predator;
+        unsigned int column;
+
+        // Killed during the current step of the anthill
+        bool killed;
+    };
+
+    /**
+     * @brief Gets in @p square the indexed ant with id @p id
+     *
+     * @return false if it has been killed
+     */
+    static bool get_indexed_ant(unsigned int id, Squarecell::Square &square);
+
+    /**
+     * @brief Kills the indexed ant with id @p id, or only records it while planning
+     *
+     */
+    void kill_indexed_ant(unsigned int id);
+
+    /**
+     * @brief Erases the ant of @p ant from its anthill, if it is still alive
+     *
+     */
+    static void kill(IndexedAnt const &ant);
+
+    /**
+     * @brief Removes the food @p target taken by the @p collector th collector, or
+     * only records it while planning
+     *
+     */
+    void take_food(FoodSet &foods, size_t collector, SlotHandle target);
+
+    /**
+     * @brief Drops the food carried by the @p collector th collector, or only
+     * records it while planning
+     *
+     */
+    void drop_food(FoodSet &foods, size_t collector);
+
+    /**
+     * @brief Counts the food brought back by the @p collector th collector, or only
+     * records it while planning: it is counted by the commit if the collector keeps
+     * the position where it reached the anthill
+     *
+     */
+    void deliver_food(size_t collector);
+
+    /* Shared by all the anthills stepping on the same thread. The ids are the
+     * positions in indexed_ants, which follow the order of the anthills and then
+     * collectors before predators */
+    static thread_local std::vector<IndexedAnt> indexed_ants;
+    static thread_local Squarecell::BucketGrid ant_buckets;
+    static thread_local std::vector<unsigned int> nearby_ants;
+
+    /**
+     * @brief Position of an ant at the beginning of \b plan
+     *
+     */
+    struct Previous
+    {
+        size_t column;
+        Squarecell::Square square;
+    };
+
+    static void record_previous(AntColumns const &ants,
+                                std::vector<Previous> &previous);
+
+    /**
+     * @brief Commits the moves of the ants of @p ants that are still alive, in the
+     * order of @p previous
+     *
+     */
+    static void commit_moves(AntColumns &ants, std::vector<Previous> const &previous);
+
+    void commit_collectors(FoodSet &foods);
 
     double n_food;
 
     std::unique_ptr<Generator> generator;
-    std::vector<std::unique_ptr<Collector>> collectors;
-    std::vector<std::unique_ptr<Defensor>> defensors;
-    std::vector<std::unique_ptr<Predator>> predators;
+    AntColumns collectors{Collector::side};
+    AntColumns defensors{Defensor::side};
+    AntColumns predators{Predator::side};
+
+    /**
+     * @brief Ant dead during the current step, it stays in the grid until
+     * \b clear_dead_ants. A collector carrying some food leaves it in the grid
+     *
+     */
+    struct DeadAnt
+    {
+        Squarecell::Square square;
+        bool loaded;
+    };
+
+    std::vector<DeadAnt> dead_ants;
+
+    // Read by the other anthills (see store_positions)
+    AntPositions collector_positions;
+    AntPositions predator_positions;
 
-    std::vector<std::unique_ptr<Ant>> dead_ants;
+    Squarecell::DistanceField home_field;
+    Squarecell::DistanceField food_field;
+    std::vector<Squarecell::Square> food_goals;
 
     State_anthill state = FREE;
+
+    Rng random_num;
+
+    /* Two-phase tick: what plan has done that is applied by commit_kills / commit.
+     * While planning, the ants killed, the foods taken and dropped are only
+     * recorded */
+    bool planning = false;
+    Squarecell::Grid planned_grid;
+
+    Squarecell::Square previous_generator{};
+    std::vector<Previous> previous_collectors;
+    std::vector<Previous> previous_defensors;
+    std::vector<Previous> previous_predators;
+
+    /**
+     * @brief What plan has done with a collector, apart from its move: the food it
+     * takes (invalid handle if none) or whether it delivers its food
+     *
+     */
+    struct CollectorPlan
+    {
+        SlotHandle food;
+        bool delivery = false;
+    };
+
+    /**
+     * @brief Records of the snapshot of an anthill (see \b write_snapshot). The state
+     * of an ant is only used by the collectors
+     *
+     */
+    struct SnapshotRecord
+    {
+        uint32_t x, y, side, color_index, state;
+        uint32_t xg, yg;
+        uint32_t n_collectors, n_defensors, n_predators;
+        double n_food;
+        Rng random_num;
+    };
+
+    struct AntRecord
+    {
+        uint32_t x, y, age, state;
+    };
+
+    std::vector<IndexedAnt> planned_kills;
+    std::vector<size_t> planned_drops;
+
+    /* Indexed by the column of the collector, so that the commit looks a collector up
+     * in O(1). The columns keep their indices from plan to commit */
+    std::vector<CollectorPlan> collector_plans;
+
+    // Searches done in advance by step (see plan_moves)
+    std::vector<Squarecell::Square> search_origins;
+    std::vector<Squarecell::Square> planned_moves;
+    std::vector<Squarecell::Square> planned_targets;
 };
 
 #endif
\ No newline at end of file
@@ -8,9 +8,11 @@
  *
  */
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "constantes.h"
 #include "element.h"
 #include "squarecell.h"
 
@@ -21,35 +23,41 @@ using std::vector;
 
 using Squarecell::Square;
 
-Ant::Ant(unsigned int x, unsigned int y, unsigned int side, unsigned int age,
-         unsigned int color_index)
-    : Element{x, y, side, true, color_index}, age(age)
+Ant::Ant(unsigned int x, unsigned int y, unsigned int side, unsigned int color_index)
+    : Element{x, y, side, true, color_index}
 {
 }
 
-string Ant::get_as_string()
+void Ant::go_back(Square const &previous)
 {
-    using std::to_string;
-    return to_string(x) + " " + to_string(y) + " " + to_string(age);
+    x = previous.x;
+    y = previous.y;
 }
 
-bool Ant::increase_age()
+bool Ant::commit_move(Square const &previous)
 {
-    age++;
-    return age < bug_life;
+    Squarecell::remove_square(previous);
+
+    bool free = !Squarecell::test_if_superposed_grid(*this);
+    if (!free)
+    {
+        go_back(previous);
+    }
+
+    Squarecell::add_square(*this);
+
+    return free;
 }
 
-vector<Square> Ant::generate_moves(Square origin, vector<int> x_shift,
-                                   vector<int> y_shift)
+void Ant::generate_moves(Square const &origin, const int *x_shift, const int *y_shift,
+                         size_t n_shifts, vector<Square> &moves)
 {
-    vector<Square> moves;
-
-    for (size_t i(0); i < x_shift.size(); i++)
+    for (size_t i(0); i < n_shifts; i++)
     {
         Square move(origin);
 
-        move.x += x_shift.at(i);
-        move.y += y_shift.at(i);
+        move.x += x_shift[i];
+        move.y += y_shift[i];
 
         // We check if the proposed new positions are inside the model
         if (Squarecell::test_square_without_message(move))
@@ -57,6 +65,123 @@ vector<Square> Ant::generate_moves(Square origin, vector<int> x_shift,
             moves.push_back(move);
         }
     }
+}
+
+// ====================================================================================
+// AntColumns
+
+AntColumns::AntColumns(unsigned int side) : side(side) {}
+
+void AntColumns::clear()
+{
+    x.clear();
+    y.clear();
+    age.clear();
+    state.clear();
+    alive.clear();
+    n_alive = 0;
+}
+
+size_t AntColumns::size() const { return x.size(); }
+
+unsigned int AntColumns::count() const { return n_alive; }
+
+void AntColumns::push_back(unsigned int x, unsigned int y, unsigned int age,
+                           State_collector state)
+{
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->age.push_back(age);
+    this->state.push_back(state);
+    alive.push_back(1);
+    n_alive++;
+}
+
+Square AntColumns::get_square(size_t i) const { return {x[i], y[i], side, true}; }
+
+void AntColumns::set_position(size_t i, Square const &square)
+{
+    x[i] = square.x;
+    y[i] = square.y;
+}
+
+void AntColumns::increase_age()
+{
+    // No branch, so that the loop can be vectorized
+    for (size_t i(0); i < age.size(); i++)
+    {
+        age[i] += alive[i];
+    }
+}
+
+bool AntColumns::test_if_too_old(size_t i) const { return age[i] >= bug_life; }
+
+void AntColumns::set_dead(size_t i)
+{
+    alive[i] = 0;
+    n_alive--;
+}
+
+void AntColumns::erase_dead()
+{
+    size_t n(0);
+    for (size_t i(0); i < size(); i++)
+    {
+        if (!alive[i])
+        {
+            continue;
+        }
+
+        x[n] = x[i];
+        y[n] = y[i];
+        age[n] = age[i];
+        state[n] = state[i];
+        alive[n] = 1;
+        n++;
+    }
+
+    x.resize(n);
+    y.resize(n);
+    age.resize(n);
+    state.resize(n);
+    alive.resize(n);
+}
+
+bool AntColumns::commit_move(size_t i, Square const &previous)
+{
+    Squarecell::remove_square(previous);
+
+    bool free = !Squarecell::test_if_superposed_grid(get_square(i));
+    if (!free)
+    {
+        set_position(i, previous);
+    }
+
+    Squarecell::add_square(get_square(i));
+
+    return free;
+}
+
+string AntColumns::get_as_string(size_t i) const
+{
+    using std::to_string;
+    return to_string(x[i]) + " " + to_string(y[i]) + " " + to_string(age[i]);
+}
+
+// ====================================================================================
+// AntPositions
+
+void AntPositions::assign(AntColumns const &columns)
+{
+    /* A copy only allocates the size copied, with the capacity of the columns the
+     * positions grow as rarely as them */
+    x.reserve(columns.x.capacity());
+    y.reserve(columns.y.capacity());
+    alive.reserve(columns.alive.capacity());
+
+    x = columns.x;
+    y = columns.y;
+    alive = columns.alive;
+}
 
-    return moves;
-}
\ No newline at end of file
+size_t AntPositions::size() const { return x.size(); }
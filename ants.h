@@ -11,10 +11,17 @@
 #ifndef ANTS_H
 #define ANTS_H
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "constantes.h"
 #include "element.h"
+#include "squarecell.h"
 
 /**
- * @brief Abstract class Ant (Base class for: Collector, Defensor, Predator)
+ * @brief Abstract class Ant (Base class for: Generator). The collectors, defensors and
+ * predators are not objects, they are the entries of the AntColumns of their anthill
  *
  */
 class Ant : public Element
@@ -26,12 +33,10 @@ public:
      * @param x position of generator in the x-axis
      * @param y position of generator in the y-axis
      * @param side size of element
-     * @param age
      * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) same as
      * graphic.h
      */
-    Ant(unsigned int x, unsigned int y, unsigned int side, unsigned int age,
-        unsigned int color_index);
+    Ant(unsigned int x, unsigned int y, unsigned int side, unsigned int color_index);
     ~Ant() override = default;
 
     /**
@@ -42,21 +47,140 @@ public:
     virtual void add_to_grid() = 0;
     virtual void remove_from_grid() = 0;
 
-    std::string get_as_string() override;
+    /**
+     * @brief Puts the ant back to @p previous without modifying the grid
+     *
+     * @param previous
+     */
+    void go_back(Squarecell::Square const &previous);
+
+    /**
+     * @brief Moves the ant in the grid from @p previous, where it is still recorded,
+     * to its current position. If the latter is no longer free, the ant goes back to
+     * @p previous instead (see Anthill::commit)
+     *
+     * @param previous
+     * @return false if the ant went back to @p previous
+     */
+    bool commit_move(Squarecell::Square const &previous);
+
+    /**
+     * @brief Appends to @p moves all the positions obtained by shifting @p origin by
+     * (@p x_shift [i], @p y_shift [i]) that are inside the model
+     *
+     * @param origin
+     * @param x_shift
+     * @param y_shift
+     * @param n_shifts size of x_shift / y_shift
+     * @param[out] moves
+     */
+    static void generate_moves(Squarecell::Square const &origin, const int *x_shift,
+                               const int *y_shift, size_t n_shifts,
+                               std::vector<Squarecell::Square> &moves);
+};
+
+/**
+ * @brief Ants of one kind of an anthill stored as a structure of arrays: the entry i
+ * of every array belongs to the same ant, in their order of birth. The columns own
+ * the state of the ants, so that aging and the scans of an anthill over its ants run
+ * over contiguous arrays. A dead ant is only flagged as not alive until
+ * \b erase_dead, so that the entries keep their index during a step
+ *
+ */
+struct AntColumns
+{
+    explicit AntColumns(unsigned int side);
+
+    // Side of all the ants of the columns
+    unsigned int side;
+
+    // Position of the center of the ant
+    std::vector<unsigned int> x;
+    std::vector<unsigned int> y;
+    std::vector<unsigned int> age;
+
+    // State_collector of the collectors, EMPTY for the other kinds
+    std::vector<uint8_t> state;
+    std::vector<uint8_t> alive;
+
+    void clear();
+
+    /**
+     * @brief Returns the number of entries, dead ants included
+     *
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the number of ants alive
+     *
+     */
+    unsigned int count() const;
+
+    void push_back(unsigned int x, unsigned int y, unsigned int age,
+                   State_collector state);
+
+    Squarecell::Square get_square(size_t i) const;
+    void set_position(size_t i, Squarecell::Square const &square);
 
     /**
-     * @brief Increases age by one
+     * @brief Increases by one the age of all the ants alive
      *
-     * @return false if age >= bug life and therefore the Ant should be dead
      */
-    bool increase_age();
+    void increase_age();
 
-    static std::vector<Square> generate_moves(Squarecell::Square origin,
-                                              std::vector<int> x_shift,
-                                              std::vector<int> y_shift);
+    /**
+     * @brief Returns true if the @p i th ant has reached the end of its life, after
+     * \b increase_age
+     *
+     */
+    bool test_if_too_old(size_t i) const;
+
+    /**
+     * @brief Flags the @p i th ant as dead, its entry is erased by \b erase_dead
+     *
+     */
+    void set_dead(size_t i);
+
+    /**
+     * @brief Erases the entries of the dead ants, the others keep their order
+     *
+     */
+    void erase_dead();
+
+    /**
+     * @brief Same as Ant::commit_move for the @p i th ant
+     *
+     * @return false if the ant went back to @p previous
+     */
+    bool commit_move(size_t i, Squarecell::Square const &previous);
+
+    /**
+     * @brief Converts the @p i th ant back to its string representation: position
+     * and age
+     *
+     */
+    std::string get_as_string(size_t i) const;
 
 private:
-    unsigned int age;
+    unsigned int n_alive = 0;
+};
+
+/**
+ * @brief Positions of the collectors / predators of an anthill as of the end of its
+ * last step, read by the other anthills (contacts, reach of the predators). It is a
+ * copy of the columns, as the anthill moves its ants while the others plan (see
+ * Anthill::plan). An ant killed by another anthill is flagged as not alive in both
+ *
+ */
+struct AntPositions
+{
+    std::vector<unsigned int> x;
+    std::vector<unsigned int> y;
+    std::vector<uint8_t> alive;
+
+    void assign(AntColumns const &columns);
+    size_t size() const;
 };
 
-#endif
\ No newline at end of file
+#endif
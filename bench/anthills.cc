@@ -0,0 +1,245 @@
+/**
+ * @file anthills.cc
+ * @author Daniel Panero, Andrea Diez
+ * @brief Scaling benchmark of Simulation::step with 6 anthills of 80 ants on a large
+ * world: it measures the time of a tick with the sequential step, then with the
+ * two-phase step and with the searches of the ants on a thread pool for a growing
+ * number of threads, and checks that each of them ends in the same world whatever the
+ * number of threads
+ * @version 0.1
+ * @date 2022-05-27
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "simulation.h"
+#include "squarecell.h"
+
+using std::string;
+using std::vector;
+
+constexpr unsigned int world_size(384);
+constexpr unsigned int n_ticks(60);
+constexpr unsigned int n_foods(300);
+
+constexpr unsigned int anthill_side(50);
+constexpr unsigned int anthill_x[] = {20, 160, 300};
+constexpr unsigned int anthill_y[] = {40, 250};
+
+// Number of threads of each run of the two parallel steps
+constexpr unsigned int n_threads[] = {1, 2, 4, 6};
+
+/**
+ * @brief Writes a configuration with 6 anthills of 80 ants (70% collectors, 15%
+ * defensors and predators) placed on a lattice, and random foods between them
+ *
+ */
+void write_world(string const &path)
+{
+    std::ofstream file(path);
+    std::default_random_engine random_num;
+    std::uniform_int_distribution<unsigned int> coordinate(2, world_size - 3);
+
+    auto inside_anthill = [](unsigned int x, unsigned int y)
+    {
+        for (auto ax : anthill_x)
+        {
+            for (auto ay : anthill_y)
+            {
+                if (x + 10 >= ax && x <= ax + anthill_side + 10 && y + 10 >= ay &&
+                    y <= ay + anthill_side + 10)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    std::set<std::pair<unsigned int, unsigned int>> foods;
+    while (foods.size() < n_foods)
+    {
+        unsigned int x = coordinate(random_num);
+        unsigned int y = coordinate(random_num);
+        if (!inside_anthill(x, y))
+        {
+            foods.insert({x, y});
+        }
+    }
+
+    file << foods.size() << "\n";
+    for (auto const &food : foods)
+    {
+        file << food.first << " " << food.second << "\n";
+    }
+
+    file << std::size(anthill_x) * std::size(anthill_y) << "\n";
+    for (auto ay : anthill_y)
+    {
+        for (auto ax : anthill_x)
+        {
+            unsigned int xg = ax + anthill_side / 2;
+            unsigned int yg = ay + anthill_side / 2;
+
+            vector<string> collectors, defensors, predators;
+            for (unsigned int y(ay + 4); y + 4 < ay + anthill_side; y += 4)
+            {
+                for (unsigned int x(ax + 4); x + 4 < ax + anthill_side; x += 4)
+                {
+                    // The generator (side 5) is left alone
+                    if (x + 4 >= xg && x <= xg + 4 && y + 4 >= yg && y <= yg + 4)
+                    {
+                        continue;
+                    }
+
+                    string ant = std::to_string(x) + " " + std::to_string(y) + " 0";
+                    unsigned int n = collectors.size() + defensors.size() +
+                                     predators.size();
+                    if (n == 80)
+                    {
+                        break;
+                    }
+
+                    if (n % 20 < 14)
+                    {
+                        collectors.push_back(ant + " false");
+                    }
+                    else if (n % 20 < 17)
+                    {
+                        defensors.push_back(ant);
+                    }
+                    else
+                    {
+                        predators.push_back(ant);
+                    }
+                }
+            }
+
+            file << ax << " " << ay << " " << anthill_side << " " << xg << " " << yg
+                 << " 20000 " << collectors.size() << " " << defensors.size() << " "
+                 << predators.size() << "\n";
+            for (auto const *ants : {&collectors, &defensors, &predators})
+            {
+                for (auto const &ant : *ants)
+                {
+                    file << ant << "\n";
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs the world of @p path for n_ticks with @p threads threads for the
+ * two-phase step and @p search_threads for the searches (see
+ * Simulation::set_search_threads), and saves the result in @p out
+ *
+ * @return the time of a tick in ms, or a negative value if the run failed
+ */
+double run(string path, unsigned int threads, unsigned int search_threads, string out)
+{
+    Squarecell::set_grid_size(world_size);
+    Simulation simulation;
+    simulation.set_threads(threads);
+    simulation.set_search_threads(search_threads);
+
+    double milliseconds = -1;
+    std::streambuf *cout = std::cout.rdbuf(nullptr);
+    if (simulation.read_file(path))
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int tick(0); tick < n_ticks; tick++)
+        {
+            simulation.step();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        milliseconds =
+            std::chrono::duration<double>(end - start).count() * 1e3 / n_ticks;
+        simulation.save_file(out);
+    }
+    std::cout.rdbuf(cout);
+
+    return milliseconds;
+}
+
+string read_all(string const &path)
+{
+    std::ifstream file(path);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+int main()
+{
+    string path("bench/anthills-world.txt");
+    write_world(path);
+
+    std::printf("6 anthills of 80 ants, world %ux%u, %u ticks, %u hardware threads\n",
+                world_size, world_size, n_ticks, std::thread::hardware_concurrency());
+    std::printf("%-12s %8s %12s %10s %10s\n", "step", "threads", "ms/tick", "speedup",
+                "vs seq.");
+
+    string out("bench/anthills-out.txt");
+    double sequential_time = run(path, 0, 0, out);
+    std::remove(out.c_str());
+    if (sequential_time < 0)
+    {
+        std::printf("sequential failed\n");
+        return 1;
+    }
+    std::printf("%-12s %8s %12.3f\n", "sequential", "-", sequential_time);
+
+    /* Each parallel step is compared with itself on one thread: the speedup is the
+     * one of the threads, the last column includes the cost of the step itself */
+    for (bool searches : {false, true})
+    {
+        double reference_time = 0;
+        string reference;
+        for (auto threads : n_threads)
+        {
+            double milliseconds = searches ? run(path, 0, threads, out)
+                                           : run(path, threads, 0, out);
+            if (milliseconds < 0)
+            {
+                std::printf("%u threads failed\n", threads);
+                return 1;
+            }
+
+            string result = read_all(out);
+            std::remove(out.c_str());
+
+            const char *check = "";
+            if (threads == 1)
+            {
+                reference_time = milliseconds;
+                reference = result;
+            }
+            else
+            {
+                check = result == reference ? "(same world)" : "(worlds differ!)";
+            }
+
+            std::printf("%-12s %8u %12.3f %9.2fx %9.2fx %s\n",
+                        searches ? "searches" : "two-phase", threads, milliseconds,
+                        reference_time / milliseconds, sequential_time / milliseconds,
+                        check);
+        }
+    }
+
+    std::remove(path.c_str());
+
+    return 0;
+}
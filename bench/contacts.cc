@@ -0,0 +1,219 @@
+/**
+ * @file contacts.cc
+ * @author Daniel Panero, Andrea Diez
+ * @brief Scaling benchmark of the contact checks between ants of different anthills
+ * (defensor - collector and predator - ant): for 6 anthills with a growing number of
+ * ants, it measures the time of one tick of checks with the scan of all the ants of
+ * the other anthills against the one with Squarecell::BucketGrid
+ * @version 0.1
+ * @date 2022-05-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "constantes.h"
+#include "predator.h"
+#include "squarecell.h"
+
+using Squarecell::Square;
+using std::vector;
+
+constexpr unsigned int n_anthills(6);
+constexpr unsigned int n_ticks(20);
+constexpr unsigned int world_size(512);
+
+// Ants per anthill of each run
+constexpr unsigned int n_ants[] = {50, 100, 250, 500};
+
+struct Colony
+{
+    vector<Square> collectors;
+    vector<Square> defensors;
+    vector<Square> predators;
+};
+
+struct Result
+{
+    double seconds;
+    unsigned long long contacts;
+};
+
+/**
+ * @brief Generates @p n ants per anthill, half collectors and a quarter defensors /
+ * predators, at random positions
+ *
+ */
+vector<Colony> generate_colonies(unsigned int n,
+                                 std::default_random_engine &random_num)
+{
+    std::uniform_int_distribution<unsigned int> coordinate(1, world_size - 2);
+    auto random_square = [&](unsigned int side) -> Square {
+        return {coordinate(random_num), coordinate(random_num), side, true};
+    };
+
+    vector<Colony> colonies(n_anthills);
+    for (auto &colony : colonies)
+    {
+        for (unsigned int i(0); i < n; i++)
+        {
+            switch (i % 4)
+            {
+            case 0:
+                colony.defensors.push_back(random_square(sizeD));
+                break;
+            case 1:
+                colony.predators.push_back(random_square(sizeP));
+                break;
+            default:
+                colony.collectors.push_back(random_square(sizeC));
+            }
+        }
+    }
+
+    return colonies;
+}
+
+Result scan_all(vector<Colony> const &colonies)
+{
+    unsigned long long contacts = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int tick(0); tick < n_ticks; tick++)
+    {
+        for (size_t i(0); i < colonies.size(); i++)
+        {
+            for (size_t j(0); j < colonies.size(); j++)
+            {
+                if (i == j)
+                {
+                    continue;
+                }
+
+                for (auto const &defensor : colonies[i].defensors)
+                {
+                    for (auto const &collector : colonies[j].collectors)
+                    {
+                        contacts += Squarecell::test_if_border_touches(defensor,
+                                                                       collector);
+                    }
+                }
+
+                for (auto const &predator : colonies[i].predators)
+                {
+                    for (auto const &collector : colonies[j].collectors)
+                    {
+                        contacts += Predator::test_if_reached_ant(predator, collector);
+                    }
+                    for (auto const &other : colonies[j].predators)
+                    {
+                        contacts += Predator::test_if_reached_ant(predator, other);
+                    }
+                }
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return {std::chrono::duration<double>(end - start).count(), contacts};
+}
+
+/**
+ * @brief Same checks as \b scan_all, the index being rebuilt for each anthill as in
+ * Anthill::step
+ *
+ */
+Result query_index(vector<Colony> const &colonies)
+{
+    Squarecell::BucketGrid buckets;
+    vector<Square const *> indexed;
+    vector<bool> is_predator;
+    vector<unsigned int> nearby;
+    unsigned long long contacts = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int tick(0); tick < n_ticks; tick++)
+    {
+        for (size_t i(0); i < colonies.size(); i++)
+        {
+            buckets.clear();
+            indexed.clear();
+            is_predator.clear();
+            for (size_t j(0); j < colonies.size(); j++)
+            {
+                if (i == j)
+                {
+                    continue;
+                }
+                for (auto const &collector : colonies[j].collectors)
+                {
+                    buckets.insert(collector, indexed.size());
+                    indexed.push_back(&collector);
+                    is_predator.push_back(false);
+                }
+                for (auto const &predator : colonies[j].predators)
+                {
+                    buckets.insert(predator, indexed.size());
+                    indexed.push_back(&predator);
+                    is_predator.push_back(true);
+                }
+            }
+
+            for (auto const &defensor : colonies[i].defensors)
+            {
+                nearby.clear();
+                buckets.query(defensor, 1, nearby);
+                for (auto id : nearby)
+                {
+                    contacts += !is_predator[id] &&
+                                Squarecell::test_if_border_touches(defensor,
+                                                                   *indexed[id]);
+                }
+            }
+
+            for (auto const &predator : colonies[i].predators)
+            {
+                nearby.clear();
+                buckets.query(predator, 1, nearby);
+                for (auto id : nearby)
+                {
+                    contacts += Predator::test_if_reached_ant(predator, *indexed[id]);
+                }
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return {std::chrono::duration<double>(end - start).count(), contacts};
+}
+
+int main()
+{
+    std::default_random_engine random_num;
+    Squarecell::set_grid_size(world_size);
+
+    std::printf("%u anthills, world %ux%u, %u ticks\n", n_anthills, world_size,
+                world_size, n_ticks);
+    std::printf("%-10s %14s %14s %10s\n", "ants", "scan ms/tick", "index ms/tick",
+                "speedup");
+
+    for (auto n : n_ants)
+    {
+        auto colonies = generate_colonies(n, random_num);
+
+        auto scan = scan_all(colonies);
+        auto index = query_index(colonies);
+
+        std::printf("%-10u %14.3f %14.3f %9.2fx %s\n", n,
+                    scan.seconds * 1e3 / n_ticks, index.seconds * 1e3 / n_ticks,
+                    scan.seconds / index.seconds,
+                    scan.contacts == index.contacts ? "" : "(contacts differ!)");
+    }
+
+    return 0;
+}
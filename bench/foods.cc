@@ -0,0 +1,132 @@
+/**
+ * @file foods.cc
+ * @author Daniel Panero, Andrea Diez
+ * @brief Benchmark of FoodSet with 10k foods on a large world: it measures the
+ * query done by the collectors (food superposing a position) with the index against a
+ * scan of all the foods, and the time of an insertion / removal
+ * @version 0.1
+ * @date 2022-05-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "food.h"
+#include "squarecell.h"
+
+using Squarecell::Square;
+using std::vector;
+
+constexpr unsigned int world_size(2048);
+constexpr unsigned int n_foods(10000);
+constexpr unsigned int n_queries(20000);
+
+struct Result
+{
+    double seconds;
+    unsigned long long checksum;
+};
+
+template <typename Function>
+Result measure(vector<Square> const &queries, Function query)
+{
+    unsigned long long checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto const &square : queries)
+    {
+        SlotHandle handle;
+        if (query(square, handle))
+        {
+            checksum += handle.index * 31ULL + handle.generation + 1;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return {std::chrono::duration<double>(end - start).count(), checksum};
+}
+
+bool scan_superposed(FoodSet &foods, Square const &square, SlotHandle &handle)
+{
+    for (auto it = foods.begin(); it != foods.end(); ++it)
+    {
+        if (Squarecell::test_if_superposed_two_square(square, (*it)->get_as_square()))
+        {
+            handle = it.handle();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void print(const char *name, Result const &scan, Result const &index)
+{
+    std::printf("%-12s %14.3f %14.3f %9.1fx %s\n", name,
+                scan.seconds * 1e6 / n_queries, index.seconds * 1e6 / n_queries,
+                scan.seconds / index.seconds,
+                scan.checksum == index.checksum ? "" : "(results differ!)");
+}
+
+int main()
+{
+    std::default_random_engine random_num;
+    std::uniform_int_distribution<unsigned int> coordinate(2, world_size - 3);
+
+    Squarecell::set_grid_size(world_size);
+
+    FoodSet foods;
+    while (foods.size() < n_foods)
+    {
+        Square square{coordinate(random_num), coordinate(random_num), 1, true};
+        if (!Squarecell::test_if_superposed_grid(square))
+        {
+            foods.insert(std::unique_ptr<Food>(new Food(square.x, square.y)));
+        }
+    }
+
+    vector<Square> queries;
+    for (unsigned int i(0); i < n_queries; i++)
+    {
+        queries.push_back({coordinate(random_num), coordinate(random_num), 3, true});
+    }
+
+    std::printf("%u foods, world %ux%u, %u queries\n", n_foods, world_size, world_size,
+                n_queries);
+    std::printf("%-12s %14s %14s %10s\n", "query", "scan us/query", "index us/query",
+                "speedup");
+
+    auto scan = measure(queries, [&](Square const &square, SlotHandle &handle)
+                        { return scan_superposed(foods, square, handle); });
+    auto index = measure(queries, [&](Square const &square, SlotHandle &handle)
+                         { return foods.find_superposed(square, handle); });
+    print("superposed", scan, index);
+
+    // Each food found is taken and a new one is dropped at the position of the query
+    unsigned long long changes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto const &square : queries)
+    {
+        SlotHandle handle;
+        Square position{square.x, square.y, 1, true};
+        if (foods.find_superposed(square, handle) &&
+            !Squarecell::test_if_superposed_grid(position))
+        {
+            foods.erase(handle);
+            foods.insert(std::unique_ptr<Food>(new Food(position.x, position.y)));
+            changes++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::printf("%llu superposed + erase + insert: %.3f us each\n", changes,
+                std::chrono::duration<double>(end - start).count() * 1e6 / changes);
+
+    return 0;
+}
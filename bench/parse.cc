@@ -0,0 +1,183 @@
+/**
+ * @file parse.cc
+ * @author Daniel Panero, Andrea Diez
+ * @brief Benchmark of the reading of a configuration with 200k foods: it measures the
+ * tokenizing of the lines with the mapped file (Config::File, Config::Line) against
+ * getline and an std::istringstream per line, then the whole Simulation::read_file
+ * @version 0.1
+ * @date 2022-05-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "config.h"
+#include "simulation.h"
+#include "squarecell.h"
+
+using std::string;
+
+constexpr unsigned int world_size(2048);
+constexpr unsigned int n_foods(200000);
+constexpr unsigned int n_runs(5);
+
+struct Result
+{
+    double seconds;
+    unsigned long long checksum;
+};
+
+/**
+ * @brief Writes @p n_foods random foods, with a comment every 1000 lines, and no
+ * anthill
+ *
+ */
+void write_world(string const &path)
+{
+    std::ofstream file(path);
+    std::default_random_engine random_num;
+    std::uniform_int_distribution<unsigned int> coordinate(2, world_size - 3);
+
+    std::set<std::pair<unsigned int, unsigned int>> foods;
+    while (foods.size() < n_foods)
+    {
+        foods.insert({coordinate(random_num), coordinate(random_num)});
+    }
+
+    file << "# foods\n" << foods.size() << "\n";
+    unsigned int i(0);
+    for (auto const &food : foods)
+    {
+        if (i++ % 1000 == 0)
+        {
+            file << "\n# next 1000 foods\n";
+        }
+        file << "    " << food.first << " " << food.second << "\n";
+    }
+    file << "# anthills\n0\n";
+}
+
+// How the lines were read before Config
+string get_next_line(std::ifstream &file)
+{
+    string line;
+    while (getline(file >> std::ws, line))
+    {
+        if (line[0] == '#')
+        {
+            continue;
+        }
+        return line;
+    }
+    return "";
+}
+
+template <typename Stream> unsigned long long sum_line(Stream &stream)
+{
+    unsigned long long sum = 0;
+    unsigned int value(0);
+    while (stream >> value)
+    {
+        sum = sum * 31 + value;
+    }
+    return sum;
+}
+
+Result tokenize_streams(string const &path)
+{
+    unsigned long long checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream file(path);
+    for (string line(get_next_line(file)); !line.empty(); line = get_next_line(file))
+    {
+        std::istringstream stream(line);
+        checksum += sum_line(stream);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return {std::chrono::duration<double>(end - start).count(), checksum};
+}
+
+Result tokenize_config(string const &path)
+{
+    unsigned long long checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    Config::File file(path);
+    for (auto line = file.next_line(); !line.empty(); line = file.next_line())
+    {
+        Config::Line stream(line);
+        checksum += sum_line(stream);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return {std::chrono::duration<double>(end - start).count(), checksum};
+}
+
+int main()
+{
+    string path("bench/parse-world.txt");
+    write_world(path);
+
+    std::printf("%u foods, world %ux%u, best of %u runs\n", n_foods, world_size,
+                world_size, n_runs);
+
+    Result streams{1e9, 0}, config{1e9, 0};
+    for (unsigned int run(0); run < n_runs; run++)
+    {
+        auto result = tokenize_streams(path);
+        if (result.seconds < streams.seconds)
+        {
+            streams = result;
+        }
+
+        result = tokenize_config(path);
+        if (result.seconds < config.seconds)
+        {
+            config = result;
+        }
+    }
+
+    std::printf("%-12s %14s %14s %10s\n", "", "streams ms", "config ms", "speedup");
+    std::printf("%-12s %14.3f %14.3f %9.1fx %s\n", "tokenize", streams.seconds * 1e3,
+                config.seconds * 1e3, streams.seconds / config.seconds,
+                streams.checksum == config.checksum ? "" : "(results differ!)");
+
+    Squarecell::set_grid_size(world_size);
+    double best = 1e9;
+    for (unsigned int run(0); run < n_runs; run++)
+    {
+        Simulation simulation;
+
+        std::streambuf *cout = std::cout.rdbuf(nullptr);
+        auto start = std::chrono::steady_clock::now();
+        bool success = simulation.read_file(path);
+        auto end = std::chrono::steady_clock::now();
+        std::cout.rdbuf(cout);
+
+        if (!success || simulation.get_n_foods() != n_foods)
+        {
+            std::printf("read_file failed\n");
+            return 1;
+        }
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    std::printf("read_file: %.3f ms\n", best * 1e3);
+
+    std::remove(path.c_str());
+
+    return 0;
+}
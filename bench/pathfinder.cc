@@ -0,0 +1,211 @@
+/**
+ * @file pathfinder.cc
+ * @author Daniel Panero, Andrea Diez
+ * @brief Microbenchmark of Squarecell::Pathfinder: it measures the nodes expanded per
+ * second for each moves policy (Collector, Defensor, Generator, Predator), both with
+ * the std::function API and with the templated one, and then the nodes expanded by
+ * the Lee algorithm against the A* search, also for the chase of the predators
+ * towards the nearest of several ants
+ * @version 0.1
+ * @date 2022-05-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "collector.h"
+#include "constantes.h"
+#include "defensor.h"
+#include "generator.h"
+#include "predator.h"
+#include "squarecell.h"
+
+using Squarecell::Square;
+using std::vector;
+
+constexpr unsigned int n_obstacles(3000);
+constexpr unsigned int n_searches(3000);
+constexpr unsigned int n_chased(8);
+
+struct Result
+{
+    unsigned long long expanded_nodes;
+    double seconds;
+    unsigned long long checksum;
+};
+
+bool test_if_reached(Square const &origin, Square const &target)
+{
+    return Squarecell::test_if_border_touches(origin, target) ||
+           Squarecell::test_if_superposed_two_square(origin, target);
+}
+
+/**
+ * @brief Generates @p n pairs (origin, target) where the origin is a free position
+ * for an ant of size @p side
+ *
+ */
+void generate_pairs(unsigned int side, vector<Square> &origins,
+                    vector<Square> &targets, std::default_random_engine &random_num)
+{
+    unsigned int g_max = Squarecell::get_grid_size();
+    std::uniform_int_distribution<unsigned int> coordinate(side, g_max - side - 1);
+
+    while (origins.size() < n_searches)
+    {
+        Square origin{coordinate(random_num), coordinate(random_num), side, true};
+        Square target{coordinate(random_num), coordinate(random_num), 1, true};
+
+        if (Squarecell::test_square_without_message(origin) &&
+            !Squarecell::test_if_superposed_grid(origin))
+        {
+            origins.push_back(origin);
+            targets.push_back(target);
+        }
+    }
+}
+
+template <typename Function, typename Target>
+Result measure(Squarecell::Pathfinder &pathfinder, Function search,
+               vector<Square> const &origins, vector<Target> const &targets)
+{
+    auto nodes_before = pathfinder.get_expanded_nodes();
+    unsigned long long checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i(0); i < origins.size(); i++)
+    {
+        auto move = search(origins[i], targets[i]);
+        checksum += move.x * 131 + move.y;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return {pathfinder.get_expanded_nodes() - nodes_before,
+            std::chrono::duration<double>(end - start).count(), checksum};
+}
+
+template <typename Moves>
+void run_policy(const std::string &name, unsigned int side,
+                const Squarecell::MoveGenerator &generate_moves,
+                std::default_random_engine &random_num)
+{
+    vector<Square> origins;
+    vector<Square> targets;
+    generate_pairs(side, origins, targets, random_num);
+
+    Squarecell::Pathfinder pathfinder;
+
+    auto before = measure(
+        pathfinder,
+        [&](Square const &origin, Square const &target) {
+            return pathfinder.lee_algorithm(origin, target, generate_moves,
+                                            &test_if_reached);
+        },
+        origins, targets);
+
+    auto after = measure(
+        pathfinder,
+        [&](Square const &origin, Square const &target) {
+            return pathfinder.lee_algorithm<Moves>(origin, target, test_if_reached);
+        },
+        origins, targets);
+
+    auto a_star = measure(
+        pathfinder,
+        [&](Square const &origin, Square const &target)
+        { return pathfinder.a_star<Moves>(origin, target, test_if_reached); },
+        origins, targets);
+
+    double before_rate = before.expanded_nodes / before.seconds;
+    double after_rate = after.expanded_nodes / after.seconds;
+
+    std::printf("%-10s %14.2f %14.2f %9.2fx %s\n", name.c_str(), before_rate / 1e6,
+                after_rate / 1e6, after_rate / before_rate,
+                before.checksum == after.checksum ? "" : "(moves differ!)");
+
+    std::printf("%-10s %14.1f %14.1f %9.2fx %s\n", "",
+                double(after.expanded_nodes) / n_searches,
+                double(a_star.expanded_nodes) / n_searches,
+                after.seconds / a_star.seconds,
+                after.checksum == a_star.checksum ? "" : "(moves differ!)");
+}
+
+/**
+ * @brief Compares the Lee algorithm and the A* search towards the nearest of
+ * \b n_chased ants, as in Predator::search_nearest_ant
+ *
+ */
+void run_chase(std::default_random_engine &random_num)
+{
+    vector<Square> origins;
+    vector<Square> targets;
+    generate_pairs(sizeP, origins, targets, random_num);
+
+    // Each search chases the target of its pair and the ones of the next pairs
+    vector<vector<Square>> chased(origins.size());
+    for (size_t i(0); i < origins.size(); i++)
+    {
+        for (size_t j(0); j < n_chased; j++)
+        {
+            chased[i].push_back(targets[(i + j) % targets.size()]);
+        }
+    }
+
+    Squarecell::Pathfinder pathfinder;
+
+    auto lee = measure(
+        pathfinder,
+        [&](Square const &origin, vector<Square> const &ants) {
+            return pathfinder.lee_algorithm<Predator::Moves>(origin, ants,
+                                                             test_if_reached);
+        },
+        origins, chased);
+
+    auto a_star = measure(
+        pathfinder,
+        [&](Square const &origin, vector<Square> const &ants)
+        { return pathfinder.a_star<Predator::Moves>(origin, ants, test_if_reached); },
+        origins, chased);
+
+    std::printf("%-10s %14.1f %14.1f %9.2fx %s\n", "chase",
+                double(lee.expanded_nodes) / n_searches,
+                double(a_star.expanded_nodes) / n_searches,
+                lee.seconds / a_star.seconds,
+                lee.checksum == a_star.checksum ? "" : "(moves differ!)");
+}
+
+int main()
+{
+    std::default_random_engine random_num;
+
+    // Random 1x1 obstacles, so that the searches are not trivial
+    unsigned int g_max = Squarecell::get_grid_size();
+    std::uniform_int_distribution<unsigned int> coordinate(0, g_max - 1);
+    for (unsigned int i(0); i < n_obstacles; i++)
+    {
+        Squarecell::add_square(
+            {coordinate(random_num), coordinate(random_num), 1, false});
+    }
+
+    std::printf("%-10s %14s %14s %10s\n", "policy", "function Mn/s", "template Mn/s",
+                "speedup");
+    std::printf("%-10s %14s %14s %10s\n", "", "Lee nodes", "A* nodes", "speedup");
+
+    run_policy<Collector::Moves>("collector", sizeC, &Collector::generate_moves,
+                                 random_num);
+    run_policy<Defensor::Moves>("defensor", sizeD, &Defensor::generate_moves,
+                                random_num);
+    run_policy<Generator::Moves>("generator", sizeG, &Generator::generate_moves,
+                                 random_num);
+    run_policy<Predator::Moves>("predator", sizeP, &Predator::generate_moves,
+                                random_num);
+    run_chase(random_num);
+
+    return 0;
+}
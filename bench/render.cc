@@ -0,0 +1,500 @@
+/**
+ * @file render.cc
+ * @author Daniel Panero, Andrea Diez
+ * @brief Benchmarks of the drawing of the model surface. First a frame of 5000
+ * collectors, drawn one primitive at a time with the draw_* functions (one context
+ * each) against Graphic::draw_frame (one context, primitives batched) and the PIXELS
+ * renderer. Then a mostly static world (5000 foods, 100 anthills and from 0 to 1600
+ * moving ants): a tick drawn with Graphic::draw_frame against
+ * Graphic::draw_frame_changes, whose cost should follow the cells that changed. Then a
+ * big world drawn with Cairo against the PIXELS renderer. Each comparison checks that
+ * both end with the same surface. Last, the scenarios of tests/correct_txt are
+ * replayed: each tick is drawn as before the frames, then with draw_frame and
+ * draw_frame_changes with both renderers, and the surfaces must be identical. The
+ * benchmark fails if any comparison gave different surfaces
+ * @version 0.1
+ * @date 2022-05-30
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "graphic-private.h"
+#include "graphic.h"
+#include "simulation.h"
+#include "squarecell.h"
+
+using std::string;
+using std::vector;
+
+constexpr unsigned int world_size(512);
+constexpr unsigned int n_foods(5000);
+constexpr unsigned int n_anthills(100);
+constexpr unsigned int n_moving_ants[] = {0, 100, 400, 1600};
+constexpr unsigned int n_ticks(50);
+constexpr unsigned int n_collectors(5000);
+constexpr unsigned int n_frames(20);
+constexpr unsigned int big_world_size(2048);
+constexpr unsigned int n_big_foods(100000);
+constexpr unsigned int n_big_anthills(36);
+constexpr unsigned int n_big_collectors(20000);
+constexpr unsigned int n_replay_ticks(100);
+
+char const *const replay_folders[] = {"tests/correct_txt",
+                                      "tests/correct_txt/R3_tests"};
+
+/**
+ * @brief Frame of the world after @p tick ticks: the foods and anthills never change,
+ * the ants move by one cell per tick along the x-axis
+ *
+ */
+void build_frame(vector<Graphic::Primitive> const &world, unsigned int tick,
+                 Graphic::Frame &frame)
+{
+    frame.clear();
+    for (auto primitive : world)
+    {
+        if (primitive.shape == Graphic::DIAGONAL_PATTERN)
+        {
+            primitive.x = 1 + (primitive.x + tick) % (world_size - 5);
+        }
+        frame.push_back(primitive);
+    }
+}
+
+/**
+ * @brief Draws @p frame as before the batching: each primitive with its draw_*
+ * function, which creates its own context
+ *
+ */
+void draw_one_by_one(Graphic::Frame const &frame)
+{
+    Graphic::clear_surface();
+
+    for (auto const &primitive : frame)
+    {
+        unsigned int x(primitive.x);
+        unsigned int y(primitive.y);
+        unsigned int side(primitive.side);
+
+        switch (primitive.shape)
+        {
+        case Graphic::DIAMOND:
+            Graphic::draw_filled_diamond(x, y, side, primitive.color_index);
+            break;
+        case Graphic::THICK_BORDER:
+            Graphic::draw_thick_border_square(x, y, side, primitive.color_index);
+            break;
+        case Graphic::FILLED:
+            Graphic::draw_filled_square(x, y, side, primitive.color_index);
+            break;
+        case Graphic::DIAGONAL_PATTERN:
+            Graphic::draw_diagonal_pattern_square(x, y, side, primitive.color_index);
+            break;
+        case Graphic::PLUS_PATTERN:
+            Graphic::draw_plus_pattern_square(x, y, side, primitive.color_index);
+            break;
+        }
+    }
+}
+
+template <typename Draw> double measure(Draw draw)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i(0); i < n_frames; i++)
+    {
+        draw();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(end - start).count() * 1e3 / n_frames;
+}
+
+/**
+ * @brief Frame of n_collectors collectors (side 3) of 6 anthills, on a lattice with
+ * both parities of the diagonal pattern
+ *
+ * @return false if a renderer gave a different surface
+ */
+bool bench_collectors()
+{
+    Graphic::Frame frame;
+    unsigned int per_row((world_size - 2) / 4);
+    for (unsigned int i(0); i < n_collectors; i++)
+    {
+        unsigned int row(i / per_row);
+        frame.push_back({Graphic::DIAGONAL_PATTERN, 1 + 4 * (i % per_row) + row % 2,
+                         1 + 4 * row, 3, i * 6 / n_collectors});
+    }
+
+    auto surface = create_surface(world_size);
+    size_t bytes = surface->get_stride() * surface->get_height();
+
+    double one_by_one = measure([&] { draw_one_by_one(frame); });
+    vector<unsigned char> reference(surface->get_data(), surface->get_data() + bytes);
+
+    double batched = measure([&] { Graphic::draw_frame(frame); });
+    bool same = std::memcmp(reference.data(), surface->get_data(), bytes) == 0;
+
+    Graphic::set_renderer(Graphic::PIXELS);
+    double pixels = measure([&] { Graphic::draw_frame(frame); });
+    bool same_pixels = std::memcmp(reference.data(), surface->get_data(), bytes) == 0;
+    Graphic::set_renderer(Graphic::CAIRO);
+
+    std::printf("%u collectors, world %ux%u, %u frames\n", n_collectors, world_size,
+                world_size, n_frames);
+    std::printf("%-14s %10.3f ms/frame\n", "one by one", one_by_one);
+    std::printf("%-14s %10.3f ms/frame %9.1fx %s\n", "batched", batched,
+                one_by_one / batched, same ? "" : "(surfaces differ!)");
+    std::printf("%-14s %10.3f ms/frame %9.1fx %s\n", "pixels", pixels,
+                one_by_one / pixels, same_pixels ? "" : "(surfaces differ!)");
+
+    return same && same_pixels;
+}
+
+/**
+ * @brief Ticks of a mostly static world with @p n_ants moving ants, drawn entirely
+ * or only where they changed. The ants move along lanes 4 cells apart, so that they
+ * never superpose each other, as in the model
+ *
+ * @return false if the changes gave a different surface
+ */
+bool run_changes(vector<Graphic::Primitive> world, unsigned int n_ants,
+                 std::default_random_engine &random_num)
+{
+    std::uniform_int_distribution<unsigned int> lane(0, (world_size - 5) / 4 - 1);
+    std::set<std::pair<unsigned int, unsigned int>> ants;
+    while (ants.size() < n_ants)
+    {
+        ants.insert({1 + 4 * lane(random_num), 1 + 4 * lane(random_num)});
+    }
+
+    unsigned int i(0);
+    for (auto const &ant : ants)
+    {
+        world.push_back(
+            {Graphic::DIAGONAL_PATTERN, ant.first, ant.second, 3, i++ % 6});
+    }
+
+    auto surface = create_surface(world_size);
+    size_t bytes = surface->get_stride() * surface->get_height();
+
+    Graphic::Frame previous, frame;
+    vector<Graphic::Area> dirty;
+
+    double full_seconds = 0;
+    for (unsigned int tick(0); tick <= n_ticks; tick++)
+    {
+        build_frame(world, tick, frame);
+
+        auto start = std::chrono::steady_clock::now();
+        Graphic::draw_frame(frame);
+        auto end = std::chrono::steady_clock::now();
+        full_seconds += std::chrono::duration<double>(end - start).count();
+    }
+    vector<unsigned char> full(surface->get_data(), surface->get_data() + bytes);
+
+    Graphic::clear_surface();
+    double changes_seconds = 0;
+    unsigned long long dirty_cells = 0;
+    for (unsigned int tick(0); tick <= n_ticks; tick++)
+    {
+        build_frame(world, tick, frame);
+
+        auto start = std::chrono::steady_clock::now();
+        Graphic::draw_frame_changes(previous, frame, dirty);
+        auto end = std::chrono::steady_clock::now();
+        std::swap(previous, frame);
+
+        // The first frame is drawn entirely in both cases
+        if (tick > 0)
+        {
+            changes_seconds += std::chrono::duration<double>(end - start).count();
+            for (auto const &area : dirty)
+            {
+                dirty_cells += area.width * area.height;
+            }
+        }
+    }
+    bool same = std::memcmp(full.data(), surface->get_data(), bytes) == 0;
+
+    std::printf("%12u %13.3f %13.3f %12.2f%% %s\n", n_ants,
+                full_seconds * 1e3 / (n_ticks + 1), changes_seconds * 1e3 / n_ticks,
+                100.0 * dirty_cells / n_ticks / (world_size * world_size),
+                same ? "" : "(surfaces differ!)");
+
+    return same;
+}
+
+/**
+ * @brief Runs \b run_changes on the same foods and anthills for each number of
+ * n_moving_ants
+ *
+ * @return false if one of them gave a different surface
+ */
+bool bench_changes()
+{
+    std::default_random_engine random_num;
+    std::uniform_int_distribution<unsigned int> coordinate(1, world_size - 5);
+
+    vector<Graphic::Primitive> world;
+    std::set<std::pair<unsigned int, unsigned int>> foods;
+    while (foods.size() < n_foods)
+    {
+        foods.insert({coordinate(random_num), coordinate(random_num)});
+    }
+    for (auto const &food : foods)
+    {
+        world.push_back(
+            {Graphic::DIAMOND, food.first, food.second, 1, Graphic::white});
+    }
+    for (unsigned int i(0); i < n_anthills; i++)
+    {
+        world.push_back({Graphic::THICK_BORDER, 1 + (i % 10) * 50,
+                         1 + (i / 10) * 50, 30, i % 6});
+    }
+
+    std::printf("\nworld %ux%u, %u foods, %u anthills, %u ticks\n", world_size,
+                world_size, n_foods, n_anthills, n_ticks);
+    std::printf("%12s %13s %13s %13s\n", "moving ants", "draw_frame ms",
+                "changes ms", "cells redrawn");
+    bool same(true);
+    for (auto n_ants : n_moving_ants)
+    {
+        same = run_changes(world, n_ants, random_num) && same;
+    }
+
+    return same;
+}
+
+/**
+ * @brief Frame of a big world (scale 2), where most of the time of Cairo goes in the
+ * rasterization of the many small shapes, drawn with both renderers
+ *
+ * @return false if the renderers gave different surfaces
+ */
+bool bench_big_world()
+{
+    std::default_random_engine random_num;
+    std::uniform_int_distribution<unsigned int> coordinate(1, big_world_size - 5);
+
+    Graphic::Frame frame;
+    for (unsigned int i(0); i < n_big_foods; i++)
+    {
+        frame.push_back({Graphic::DIAMOND, coordinate(random_num),
+                         coordinate(random_num), 1, Graphic::white});
+    }
+    for (unsigned int i(0); i < n_big_anthills; i++)
+    {
+        frame.push_back({Graphic::THICK_BORDER, 1 + (i % 6) * 340, 1 + (i / 6) * 340,
+                         300, i % 6});
+    }
+    for (unsigned int i(0); i < n_big_collectors; i++)
+    {
+        frame.push_back({Graphic::DIAGONAL_PATTERN, coordinate(random_num),
+                         coordinate(random_num), 3, i % 6});
+    }
+
+    auto surface = create_surface(big_world_size);
+    size_t bytes = surface->get_stride() * surface->get_height();
+
+    double cairo = measure([&] { Graphic::draw_frame(frame); });
+    vector<unsigned char> reference(surface->get_data(), surface->get_data() + bytes);
+
+    Graphic::set_renderer(Graphic::PIXELS);
+    double pixels = measure([&] { Graphic::draw_frame(frame); });
+    bool same = std::memcmp(reference.data(), surface->get_data(), bytes) == 0;
+    Graphic::set_renderer(Graphic::CAIRO);
+
+    std::printf("\nworld %ux%u (%dx%d pixels), %u foods, %u anthills, %u collectors\n",
+                big_world_size, big_world_size, surface->get_width(),
+                surface->get_height(), n_big_foods, n_big_anthills, n_big_collectors);
+    std::printf("%-14s %10.3f ms/frame\n", "cairo", cairo);
+    std::printf("%-14s %10.3f ms/frame %9.1fx %s\n", "pixels", pixels, cairo / pixels,
+                same ? "" : "(surfaces differ!)");
+
+    return same;
+}
+
+/**
+ * @brief Paths of the surface that are compared with the drawing one primitive at a
+ * time on the replayed scenarios
+ *
+ */
+struct ReplayPath
+{
+    char const *name;
+    double seconds = 0;
+    unsigned int differences = 0;
+
+    /* Surface drawn by the path so far, for the paths which draw only the changes
+     * (empty for the others) */
+    vector<unsigned char> surface;
+};
+
+/**
+ * @brief Restores @p path.surface on @p surface (if there is one), runs @p draw and
+ * compares the result with @p reference
+ *
+ */
+template <typename Draw>
+void replay_path(ReplayPath &path, Cairo::RefPtr<Cairo::ImageSurface> const &surface,
+                 vector<unsigned char> const &reference, Draw draw)
+{
+    unsigned char *data = surface->get_data();
+    if (!path.surface.empty())
+    {
+        std::copy(path.surface.begin(), path.surface.end(), data);
+        surface->mark_dirty();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    draw();
+    surface->flush();
+    auto end = std::chrono::steady_clock::now();
+    path.seconds += std::chrono::duration<double>(end - start).count();
+
+    if (!std::equal(reference.begin(), reference.end(), data))
+    {
+        path.differences++;
+    }
+    if (!path.surface.empty())
+    {
+        path.surface.assign(data, data + reference.size());
+    }
+}
+
+/**
+ * @brief Replays n_replay_ticks ticks of each scenario of replay_folders, draws each
+ * tick with every path and compares it with the drawing one primitive at a time
+ *
+ * @return false if a path gave a different surface
+ */
+bool replay_scenarios()
+{
+    vector<string> paths;
+    for (auto folder : replay_folders)
+    {
+        for (auto const &entry : std::filesystem::directory_iterator(folder))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".txt")
+            {
+                paths.push_back(entry.path().string());
+            }
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    ReplayPath reference{"one by one", 0, 0, {}};
+    ReplayPath batched{"batched", 0, 0, {}};
+    ReplayPath changes{"frame changes", 0, 0, {}};
+    ReplayPath pixels{"pixels", 0, 0, {}};
+    ReplayPath pixel_changes{"pixels changes", 0, 0, {}};
+
+    unsigned int n_scenarios(0);
+    unsigned long n_frames(0);
+    for (auto &path : paths)
+    {
+        Simulation simulation;
+        std::streambuf *cout = std::cout.rdbuf(nullptr);
+        bool loaded = simulation.read_file(path);
+        std::cout.rdbuf(cout);
+        if (!loaded)
+        {
+            continue;
+        }
+        n_scenarios++;
+
+        auto surface = create_surface(Squarecell::get_grid_size());
+        size_t bytes = surface->get_stride() * surface->get_height();
+
+        Graphic::Frame previous, frame;
+        vector<Graphic::Area> dirty;
+        vector<unsigned char> expected;
+        changes.surface.assign(bytes, 0);
+        pixel_changes.surface.assign(bytes, 0);
+        Graphic::Frame pixel_previous;
+
+        for (unsigned int tick(0); tick <= n_replay_ticks; tick++)
+        {
+            simulation.draw(frame);
+
+            auto start = std::chrono::steady_clock::now();
+            draw_one_by_one(frame);
+            surface->flush();
+            auto end = std::chrono::steady_clock::now();
+            reference.seconds += std::chrono::duration<double>(end - start).count();
+            expected.assign(surface->get_data(), surface->get_data() + bytes);
+
+            replay_path(batched, surface, expected,
+                        [&] { Graphic::draw_frame(frame); });
+            replay_path(changes, surface, expected,
+                        [&] { Graphic::draw_frame_changes(previous, frame, dirty); });
+
+            Graphic::set_renderer(Graphic::PIXELS);
+            replay_path(pixels, surface, expected,
+                        [&] { Graphic::draw_frame(frame); });
+            replay_path(
+                pixel_changes, surface, expected,
+                [&] { Graphic::draw_frame_changes(pixel_previous, frame, dirty); });
+            Graphic::set_renderer(Graphic::CAIRO);
+            pixel_previous = frame;
+
+            std::swap(previous, frame);
+            n_frames++;
+
+            cout = std::cout.rdbuf(nullptr);
+            bool running = simulation.step();
+            std::cout.rdbuf(cout);
+            if (!running)
+            {
+                break;
+            }
+        }
+    }
+
+    std::printf("\n%u scenarios of the tests, %lu frames\n", n_scenarios, n_frames);
+    std::printf("%-14s %10.3f ms/frame\n", reference.name,
+                reference.seconds * 1e3 / n_frames);
+
+    bool same(true);
+    for (auto const *path : {&batched, &changes, &pixels, &pixel_changes})
+    {
+        std::printf("%-14s %10.3f ms/frame %9.1fx ", path->name,
+                    path->seconds * 1e3 / n_frames, reference.seconds / path->seconds);
+        if (path->differences == 0)
+        {
+            std::printf("\n");
+        }
+        else
+        {
+            std::printf("(%u frames differ!)\n", path->differences);
+            same = false;
+        }
+    }
+
+    return same;
+}
+
+int main()
+{
+    // Every comparison runs, even after a failure, so that all of them are reported
+    bool same = bench_collectors();
+    same = bench_changes() && same;
+    same = bench_big_world() && same;
+    same = replay_scenarios() && same;
+
+    return same ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+/**
+ * @file scenarios.cc
+ * @author Daniel Panero, Andrea Diez
+ * @brief Benchmark of Simulation::step over the scenarios of tests/test_txt and
+ * tests/correct_txt/R3_tests, and over synthetic large worlds. Each scenario is run
+ * for a fixed number of ticks (or until it ends) and its ticks/s, p50 / p99 tick
+ * latency, peak RSS and allocations per tick are printed as JSON, to be compared
+ * between commits.
+ * The scenarios which can't be read (the error tests) are reported as such
+ * @version 0.1
+ * @date 2022-06-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "allocation.h"
+#include "simulation.h"
+#include "squarecell.h"
+
+using std::string;
+using std::vector;
+
+// Number of ticks of the test scenarios
+constexpr unsigned int n_ticks(200);
+
+// Size of the world of the test scenarios (the default one of Squarecell)
+constexpr unsigned int test_world_size(128);
+
+char const *const scenario_folders[] = {"tests/test_txt",
+                                        "tests/correct_txt/R3_tests"};
+
+constexpr unsigned int anthill_side(50);
+constexpr unsigned int anthill_spacing(80);
+constexpr unsigned int n_ants_per_anthill(80);
+
+/**
+ * @brief Synthetic world: a lattice of n_columns x n_rows anthills of
+ * n_ants_per_anthill ants, and random foods between them. Their ticks are much slower
+ * than the ones of the test scenarios, so they run for fewer ticks
+ *
+ */
+struct SyntheticWorld
+{
+    char const *name;
+    unsigned int size;
+    unsigned int n_columns;
+    unsigned int n_rows;
+    unsigned int n_foods;
+    unsigned int n_ticks;
+};
+
+constexpr SyntheticWorld synthetic_worlds[] = {
+    {"synthetic-512", 512, 2, 2, 500, 200},
+    {"synthetic-1024", 1024, 3, 3, 2000, 50},
+};
+
+struct Result
+{
+    string name;
+    bool loaded = false;
+    unsigned int ticks = 0;
+    double ticks_per_second = 0;
+    double p50_ms = 0;
+    double p99_ms = 0;
+    long peak_rss_kb = 0;
+    double allocations_per_tick = 0;
+};
+
+/**
+ * @brief Writes the configuration of @p world, with the same anthills as
+ * bench/anthills (70% collectors, 15% defensors and predators around the generator)
+ *
+ */
+void write_world(SyntheticWorld const &world, string const &path)
+{
+    std::ofstream file(path);
+    std::default_random_engine random_num;
+    std::uniform_int_distribution<unsigned int> coordinate(2, world.size - 3);
+
+    vector<std::pair<unsigned int, unsigned int>> anthills;
+    for (unsigned int row(0); row < world.n_rows; row++)
+    {
+        for (unsigned int column(0); column < world.n_columns; column++)
+        {
+            anthills.push_back({20 + column * (anthill_side + anthill_spacing),
+                                20 + row * (anthill_side + anthill_spacing)});
+        }
+    }
+
+    auto inside_anthill = [&](unsigned int x, unsigned int y)
+    {
+        for (auto const &anthill : anthills)
+        {
+            if (x + 10 >= anthill.first && x <= anthill.first + anthill_side + 10 &&
+                y + 10 >= anthill.second && y <= anthill.second + anthill_side + 10)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::set<std::pair<unsigned int, unsigned int>> foods;
+    while (foods.size() < world.n_foods)
+    {
+        unsigned int x = coordinate(random_num);
+        unsigned int y = coordinate(random_num);
+        if (!inside_anthill(x, y))
+        {
+            foods.insert({x, y});
+        }
+    }
+
+    file << foods.size() << "\n";
+    for (auto const &food : foods)
+    {
+        file << food.first << " " << food.second << "\n";
+    }
+
+    file << anthills.size() << "\n";
+    for (auto const &anthill : anthills)
+    {
+        unsigned int ax(anthill.first), ay(anthill.second);
+        unsigned int xg = ax + anthill_side / 2;
+        unsigned int yg = ay + anthill_side / 2;
+
+        vector<string> collectors, defensors, predators;
+        for (unsigned int y(ay + 4); y + 4 < ay + anthill_side; y += 4)
+        {
+            for (unsigned int x(ax + 4); x + 4 < ax + anthill_side; x += 4)
+            {
+                // The generator (side 5) is left alone
+                if (x + 4 >= xg && x <= xg + 4 && y + 4 >= yg && y <= yg + 4)
+                {
+                    continue;
+                }
+
+                string ant = std::to_string(x) + " " + std::to_string(y) + " 0";
+                unsigned int n =
+                    collectors.size() + defensors.size() + predators.size();
+                if (n == n_ants_per_anthill)
+                {
+                    break;
+                }
+
+                if (n % 20 < 14)
+                {
+                    collectors.push_back(ant + " false");
+                }
+                else if (n % 20 < 17)
+                {
+                    defensors.push_back(ant);
+                }
+                else
+                {
+                    predators.push_back(ant);
+                }
+            }
+        }
+
+        file << ax << " " << ay << " " << anthill_side << " " << xg << " " << yg
+             << " 20000 " << collectors.size() << " " << defensors.size() << " "
+             << predators.size() << "\n";
+        for (auto const *ants : {&collectors, &defensors, &predators})
+        {
+            for (auto const &ant : *ants)
+            {
+                file << ant << "\n";
+            }
+        }
+    }
+}
+
+/**
+ * @brief Resets the peak RSS of the process to its current RSS, so that the peak of
+ * each scenario can be measured (Linux only, otherwise the peak stays the one of the
+ * whole process)
+ *
+ */
+void reset_peak_rss()
+{
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+long get_peak_rss_kb()
+{
+    std::ifstream status("/proc/self/status");
+    string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return std::stol(line.substr(6));
+        }
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * @brief Latency of the tick at @p percentile (nearest rank) of @p latencies
+ *
+ */
+double get_percentile(vector<double> latencies, double percentile)
+{
+    if (latencies.empty())
+    {
+        return 0;
+    }
+
+    size_t rank = std::ceil(percentile / 100 * latencies.size());
+    size_t index = std::min(std::max<size_t>(rank, 1), latencies.size()) - 1;
+    std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+    return latencies[index];
+}
+
+/**
+ * @brief Reads the scenario @p path in a world of size @p size and steps it for
+ * @p max_ticks ticks
+ *
+ */
+Result run(string const &name, string path, unsigned int size, unsigned int max_ticks)
+{
+    Result result;
+    result.name = name;
+
+    reset_peak_rss();
+    Squarecell::set_grid_size(size);
+    Simulation simulation;
+
+    std::streambuf *cout = std::cout.rdbuf(nullptr);
+    result.loaded = simulation.read_file(path);
+    if (result.loaded)
+    {
+        vector<double> latencies;
+        latencies.reserve(max_ticks);
+
+        auto allocations = Allocation::get_count();
+        auto start = std::chrono::steady_clock::now();
+        bool running(true);
+        while (running && result.ticks < max_ticks)
+        {
+            auto tick_start = std::chrono::steady_clock::now();
+            running = simulation.step();
+            auto tick_end = std::chrono::steady_clock::now();
+
+            latencies.push_back(
+                std::chrono::duration<double>(tick_end - tick_start).count() * 1e3);
+            result.ticks++;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        // The latencies were reserved, they don't count in the allocations
+        double seconds = std::chrono::duration<double>(end - start).count();
+        result.ticks_per_second = seconds > 0 ? result.ticks / seconds : 0;
+        result.allocations_per_tick =
+            double(Allocation::get_count() - allocations) / result.ticks;
+        result.p50_ms = get_percentile(latencies, 50);
+        result.p99_ms = get_percentile(latencies, 99);
+    }
+    std::cout.rdbuf(cout);
+
+    result.peak_rss_kb = get_peak_rss_kb();
+    return result;
+}
+
+/**
+ * @brief Prints @p value as a JSON string (the names are paths, only the quotes and
+ * backslashes have to be escaped)
+ *
+ */
+void print_json_string(string const &value)
+{
+    std::putchar('"');
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            std::putchar('\\');
+        }
+        std::putchar(c);
+    }
+    std::putchar('"');
+}
+
+int main()
+{
+    vector<Result> results;
+
+    for (auto folder : scenario_folders)
+    {
+        vector<string> paths;
+        for (auto const &entry : std::filesystem::directory_iterator(folder))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".txt")
+            {
+                paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+
+        for (auto const &path : paths)
+        {
+            results.push_back(run(path, path, test_world_size, n_ticks));
+        }
+    }
+
+    for (auto const &world : synthetic_worlds)
+    {
+        string path("bench/scenarios-world.txt");
+        write_world(world, path);
+        results.push_back(run(world.name, path, world.size, world.n_ticks));
+        std::remove(path.c_str());
+    }
+
+    std::printf("{\n  \"scenarios\": [");
+    for (size_t i(0); i < results.size(); i++)
+    {
+        auto const &result = results[i];
+
+        std::printf("%s\n    {\"name\": ", i == 0 ? "" : ",");
+        print_json_string(result.name);
+        std::printf(", \"loaded\": %s", result.loaded ? "true" : "false");
+        if (result.loaded)
+        {
+            std::printf(", \"ticks\": %u, \"ticks_per_second\": %.1f, "
+                        "\"p50_ms\": %.4f, \"p99_ms\": %.4f, "
+                        "\"allocations_per_tick\": %.2f",
+                        result.ticks, result.ticks_per_second, result.p50_ms,
+                        result.p99_ms, result.allocations_per_tick);
+        }
+        std::printf(", \"peak_rss_kb\": %ld}", result.peak_rss_kb);
+    }
+    std::printf("\n  ]\n}\n");
+
+    return 0;
+}
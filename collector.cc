@@ -10,204 +10,255 @@
 
 #include <cmath>
 #include <memory>
-#include <sstream>
+#include <stdexcept>
+#include <string_view>
 #include <vector>
 
+#include "config.h"
 #include "constantes.h"
 #include "message.h"
 #include "squarecell.h"
 
 #include "collector.h"
 
-using std::istringstream;
 using std::string;
+using std::string_view;
 using std::unique_ptr;
 using std::vector;
 
 using Squarecell::Square;
 
-unsigned int const g_max(128);
 unsigned int const distance_border(7);
-unsigned int difference(unsigned int a, unsigned int b);
 
 // ====================================================================================
 // Initialization - Misc
 
-Collector::Collector(unsigned int x, unsigned int y, unsigned int age,
-                     State_collector state, unsigned int color_index)
-    : Ant{x, y, sizeC, age, color_index}, state(state)
+void Collector::insert(AntColumns &collectors, unsigned int x, unsigned int y,
+                       unsigned int age, State_collector state)
 {
-    Squarecell::test_square(*this);
-    add_to_grid();
-}
+    Square collector{x, y, sizeC, true};
 
-Collector::~Collector()
-{
-    remove_from_grid();
-    undraw();
-
-    /**
-     * If it was carrying some food, we have to add it back to the simulation. This was
-     * automatically done by the anthill which has direct access to the food, but since
-     * we are clearing the grid and the surface, this would eliminate the food.
-     * Therefore we have to manually set the position as true and redraw it
-     *
-     */
-    if (state == LOADED)
-    {
-        Square food{x, y, 1, true};
+    Squarecell::test_square(collector);
+    add_to_grid(collector);
 
-        Squarecell::add_square(food);
-        Squarecell::draw_as_diamond(food, "white");
-    }
+    collectors.push_back(x, y, age, state);
 }
 
-void Collector::add_to_grid()
+void Collector::add_to_grid(Square const &collector)
 {
     unsigned int superposed_x(0);
     unsigned int superposed_y(0);
 
-    if (Squarecell::test_if_superposed_grid(*this, superposed_x, superposed_y))
+    if (Squarecell::test_if_superposed_grid(collector, superposed_x, superposed_y))
     {
-        throw std::invalid_argument(
-            message::collector_overlap(x, y, superposed_x, superposed_y));
+        throw std::invalid_argument(message::collector_overlap(
+            collector.x, collector.y, superposed_x, superposed_y));
     }
 
-    Squarecell::add_square(*this);
+    Squarecell::add_square(collector);
 }
 
-void Collector::remove_from_grid() { Squarecell::remove_square(*this); }
-
-void Collector::draw() { Squarecell::draw_diagonal_pattern(*this, get_color_index()); }
-
-void Collector::undraw() { Squarecell::undraw_square(*this); }
-
-string Collector::get_as_string()
+void Collector::draw(Graphic::Frame &frame, AntColumns const &collectors,
+                     unsigned int color_index)
 {
-    return Ant::get_as_string() + " " +
-           (state == State_collector::LOADED ? "true" : "false");
+    for (size_t i(0); i < collectors.size(); i++)
+    {
+        if (collectors.alive[i])
+        {
+            Squarecell::draw_diagonal_pattern(frame, collectors.get_square(i),
+                                              color_index);
+        }
+    }
 }
 
-State_collector Collector::get_state() { return state; }
+string Collector::get_as_string(AntColumns const &collectors, size_t i)
+{
+    return collectors.get_as_string(i) + " " +
+           (collectors.state[i] == LOADED ? "true" : "false");
+}
 
 // ====================================================================================
 // Simulation
 
-bool Collector::step() { return increase_age(); }
-
-bool Collector::return_to_anthill(Square &anthill_square)
+bool Collector::return_to_anthill(AntColumns &collectors, size_t i,
+                                  Square &anthill_square,
+                                  Squarecell::DistanceField const &home_field)
 {
-    remove_from_grid();
-    undraw();
+    auto collector = collectors.get_square(i);
+    Squarecell::remove_square(collector);
 
-    auto move =
-        Squarecell::lee_algorithm(*this, anthill_square, &Collector::generate_moves,
-                                  &Collector::test_if_reached_anthill);
+    if (!test_if_reached_anthill(collector, anthill_square))
+    {
+        auto move = home_field.descend<Moves>(collector);
 
-    x = move.x;
-    y = move.y;
+        collector.x = move.x;
+        collector.y = move.y;
+    }
 
-    add_to_grid();
-    draw();
+    collectors.set_position(i, collector);
+    add_to_grid(collector);
 
-    if (Collector::test_if_reached_anthill(*this, anthill_square))
+    if (test_if_reached_anthill(collector, anthill_square))
     {
-        state = EMPTY;
+        collectors.state[i] = EMPTY;
         return true;
     }
 
     return false;
 }
 
-bool Collector::go_outside(Square &anthill_square)
+bool Collector::go_outside(AntColumns &collectors, size_t i, Square &anthill_square,
+                           Square const *planned)
 {
-    remove_from_grid();
-    undraw();
+    auto collector = collectors.get_square(i);
+    Squarecell::remove_square(collector);
 
-    auto move = Squarecell::lee_algorithm(
-        *this, anthill_square, &Collector::generate_moves,
-        &Collector::test_if_inside_anthill_or_near_border_model);
+    auto move = planned && !Squarecell::test_if_superposed_grid(*planned)
+                    ? *planned
+                    : search_outside(collector, anthill_square);
 
-    x = move.x;
-    y = move.y;
+    collector.x = move.x;
+    collector.y = move.y;
 
-    add_to_grid();
-    draw();
+    collectors.set_position(i, collector);
+    add_to_grid(collector);
 
     return false;
 }
 
-bool Collector::search_food(std::unique_ptr<Food> &food)
+Square Collector::search_outside(Square const &origin, Square const &anthill)
 {
-    auto food_square = food->get_as_square();
-
-    remove_from_grid();
-    undraw();
+    return Squarecell::lee_algorithm<Moves>(
+        origin, anthill, [](Square const &origin, Square const &anthill)
+        { return test_if_inside_anthill_or_near_border_model(origin, anthill); });
+}
 
-    food->remove_from_grid();
+bool Collector::search_food(AntColumns &collectors, size_t i, FoodSet &foods,
+                            Squarecell::DistanceField const &food_field,
+                            SlotHandle &target)
+{
+    auto collector = collectors.get_square(i);
+    Squarecell::remove_square(collector);
 
-    auto move =
-        Squarecell::lee_algorithm(*this, food_square, &Collector::generate_moves,
-                                  &Squarecell::test_if_superposed_two_square);
+    bool reached = take_adjacent_food(collector, foods, food_field, target);
+    if (!reached)
+    {
+        auto move = food_field.descend<Moves>(collector);
 
-    x = move.x;
-    y = move.y;
+        collector.x = move.x;
+        collector.y = move.y;
+    }
 
-    add_to_grid();
-    draw();
+    collectors.set_position(i, collector);
+    add_to_grid(collector);
 
-    if (Squarecell::test_if_superposed_two_square(*this, food_square))
+    if (reached)
     {
-        state = LOADED;
-        return true;
+        collectors.state[i] = LOADED;
     }
 
-    food->add_to_grid();
-
-    return false;
+    return reached;
 }
 
-bool Collector::find_target_food(vector<unique_ptr<Food>> &foods, size_t &target)
+bool Collector::can_reach_food(Square const &collector,
+                               Squarecell::DistanceField const &food_field)
 {
-    unsigned int best_distance = g_max;
-    bool found = false;
+    return food_field.get_distance(collector) !=
+           Squarecell::DistanceField::unreachable;
+}
 
-    for (size_t i(0); i < foods.size(); i++)
+bool Collector::take_adjacent_food(Square &collector, FoodSet &foods,
+                                   Squarecell::DistanceField const &food_field,
+                                   SlotHandle &target)
+{
+    for (size_t i(0); i < Moves::n; i++)
     {
-        auto food_square = foods[i]->get_as_square();
+        Square move(collector);
+        move.x += Moves::x_shift[i];
+        move.y += Moves::y_shift[i];
+
+        if (food_field.get_distance(move) != 0)
+        {
+            continue;
+        }
 
-        if (difference(food_square.y, food_square.x) % 2 == difference(y, x) % 2)
+        SlotHandle handle;
+        if (!foods.find_superposed(move, handle))
         {
-            unsigned int distance =
-                std::max(difference(x, food_square.x), difference(y, food_square.y));
-            if (distance < best_distance)
-            {
-                target = i;
-                best_distance = distance;
-                found = true;
-            }
+            continue;
         }
+
+        // The food is only taken if nothing else is in the way
+        auto *food = foods.get(handle);
+        food->remove_from_grid();
+        if (!Squarecell::test_if_superposed_grid(move))
+        {
+            collector.x = move.x;
+            collector.y = move.y;
+            target = handle;
+
+            return true;
+        }
+        food->add_to_grid();
     }
 
-    return found;
+    return false;
 }
 
-void Collector::drop_food(vector<unique_ptr<Food>> &foods)
+void Collector::drop_food(AntColumns const &collectors, size_t i, FoodSet &foods)
 {
-    if (state == LOADED)
+    if (collectors.state[i] == LOADED)
     {
+        auto collector = collectors.get_square(i);
+
         // In order to add the new food we have first to empty the grid
-        Squarecell::remove_square(*this);
+        Squarecell::remove_square(collector);
 
-        unique_ptr<Food> food(new Food{x, y});
-        foods.push_back(std::move(food));
+        unique_ptr<Food> food(new Food{collector.x, collector.y});
+        foods.insert(std::move(food));
 
         /** We have to add back the square as the zone will be free only after
          * all the Anthills are updated */
-        Squarecell::add_square(*this);
+        Squarecell::add_square(collector);
     }
 }
 
+bool Collector::commit_take(AntColumns &collectors, size_t i, FoodSet &foods,
+                            SlotHandle target, Square const &previous)
+{
+    auto *food = foods.get(target);
+    if (!food)
+    {
+        // Taken by a collector committed before
+        collectors.set_position(i, previous);
+    }
+    else
+    {
+        food->remove_from_grid();
+        if (collectors.commit_move(i, previous))
+        {
+            foods.erase(target);
+            return true;
+        }
+        food->add_to_grid();
+    }
+
+    collectors.state[i] = EMPTY;
+    return false;
+}
+
+bool Collector::commit_delivery(AntColumns &collectors, size_t i,
+                                Square const &previous)
+{
+    if (collectors.commit_move(i, previous))
+    {
+        return true;
+    }
+
+    collectors.state[i] = LOADED;
+    return false;
+}
+
 bool Collector::test_if_inside_anthill_or_near_border_model(
     Squarecell::Square const &origin, Squarecell::Square const &anthill)
 {
@@ -221,6 +272,7 @@ bool Collector::test_if_inside_anthill_or_near_border_model(
             return false;
         }
 
+        unsigned int g_max = Squarecell::get_grid_size();
         if (x > g_max - distance_border || y > g_max - distance_border)
         {
             return false;
@@ -239,23 +291,19 @@ bool Collector::test_if_reached_anthill(Squarecell::Square const &origin,
            Squarecell::test_if_superposed_two_square(origin, anthill);
 }
 
-vector<Square> Collector::generate_moves(Square origin)
+void Collector::generate_moves(Square const &origin, vector<Square> &moves)
 {
-    // All the possible shifts combination: TOP-RIGHT,  BOTTOM-RIGHT...
-    vector<int> x_shift{1, 1, -1, -1};
-    vector<int> y_shift{1, -1, 1, -1};
-
-    return Ant::generate_moves(origin, x_shift, y_shift);
+    Ant::generate_moves(origin, Moves::x_shift, Moves::y_shift, Moves::n, moves);
 }
 
-unique_ptr<Collector> Collector::parse_line(string &line, unsigned int color_index)
+void Collector::parse_line(string_view line, AntColumns &collectors)
 {
     unsigned int x(0);
     unsigned int y(0);
     unsigned int age(0);
-    string tmp("false");
+    string_view tmp("false");
 
-    istringstream stream(line);
+    Config::Line stream(line);
     stream >> x;
     stream >> y;
     stream >> age;
@@ -266,10 +314,5 @@ unique_ptr<Collector> Collector::parse_line(string &line, unsigned int color_ind
     {
         state = State_collector::LOADED;
     }
-    return unique_ptr<Collector>(new Collector(x, y, age, state, color_index));
-}
-
-unsigned int difference(unsigned int a, unsigned int b)
-{
-    return a >= b ? a - b : b - a;
+    insert(collectors, x, y, age, state);
 }
@@ -11,76 +11,156 @@
 #ifndef ANTS_COLLECTOR_H
 #define ANTS_COLLECTOR_H
 
-#include <memory>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "ants.h"
+#include "constantes.h"
 #include "food.h"
+#include "slotmap.h"
 #include "squarecell.h"
 
-class Collector : public Ant
+/**
+ * @brief Behaviour of the collectors, which are the entries @p i of the AntColumns
+ * @p collectors of their anthill
+ *
+ */
+class Collector
 {
 public:
+    static constexpr unsigned int side = sizeC;
+
     /**
-     * @brief Constructs a new Collector instance
+     * @brief Appends a new collector to @p collectors and adds it to the grid
      *
+     * @param collectors
      * @param x position of collector in the x-axis
      * @param y position of collector in the y-axis
      * @param age
      * @param state state of collector: EMPTY / LOADED
-     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) same as
-     * graphic.h
      */
-    Collector(unsigned int x, unsigned int y, unsigned int age, State_collector state,
-              unsigned int color_index);
-    ~Collector() override;
-
-    void add_to_grid() override;
-    void remove_from_grid() override;
+    static void insert(AntColumns &collectors, unsigned int x, unsigned int y,
+                       unsigned int age, State_collector state);
 
-    void draw() override;
-    void undraw() override;
+    /**
+     * @brief Checks that position in the grid is empty and either throw an error or
+     * fills the grid
+     *
+     * @param collector
+     */
+    static void add_to_grid(Squarecell::Square const &collector);
 
-    std::string get_as_string() override;
+    /**
+     * @brief Appends the collectors alive of @p collectors to @p frame
+     *
+     */
+    static void draw(Graphic::Frame &frame, AntColumns const &collectors,
+                     unsigned int color_index);
 
-    State_collector get_state();
+    static std::string get_as_string(AntColumns const &collectors, size_t i);
 
     /**
-     * @brief It increases the age and return true if the predator died of old age
+     * @brief Moves the collector to \b anthill following @p home_field, if it reaches
+     * it border it returns true and the state change to EMPTY
      *
-     * @return true if dead
+     * @param collectors
+     * @param i
+     * @param anthill_square
+     * @param home_field distance field to \b anthill shared by all the loaded
+     * collectors of the anthill
+     * @return true if it reaches the border of \b anthill
      */
-    bool step();
+    static bool return_to_anthill(AntColumns &collectors, size_t i,
+                                  Squarecell::Square &anthill_square,
+                                  Squarecell::DistanceField const &home_field);
 
     /**
-     * @brief Moves the collector to \b anthill, if it reaches it border it returns
-     * true and the state change to EMPTY
+     * @brief Moves the collector out of \b anthill, to the nearest position outside
+     * of it and away from its border
      *
+     * @param collectors
+     * @param i
      * @param anthill_square
-     * @return true if it reaches the border of \b anthill
+     * @param planned next position searched in advance (see Anthill::plan_moves),
+     * used instead of a new search if it is still free
+     * @return false
+     */
+    static bool go_outside(AntColumns &collectors, size_t i,
+                           Squarecell::Square &anthill_square,
+                           Squarecell::Square const *planned = nullptr);
+
+    /**
+     * @brief Returns the first move of \b go_outside from @p origin, which must not be
+     * in the grid. It only reads the grid
+     *
+     * @param origin
+     * @param anthill
      */
-    bool return_to_anthill(Squarecell::Square &anthill_square);
+    static Squarecell::Square search_outside(Squarecell::Square const &origin,
+                                             Squarecell::Square const &anthill);
 
-    bool go_outside(Squarecell::Square &anthill_square);
+    /**
+     * @brief Moves the collector to the nearest food following @p food_field, if it
+     * superposes with a food it returns true and the state changes to LOADED
+     *
+     * @param collectors
+     * @param i
+     * @param foods
+     * @param food_field distance field to all the foods (see
+     * Anthill::compute_food_field)
+     * @param[out] target handle of the food taken
+     * @return true if it reaches a food
+     */
+    static bool search_food(AntColumns &collectors, size_t i, FoodSet &foods,
+                            Squarecell::DistanceField const &food_field,
+                            SlotHandle &target);
+
+    /**
+     * @brief Returns true if a food can be reached following @p food_field from
+     * @p collector. As the collectors only move diagonally, it is also the test of
+     * parity between the collector and the foods
+     *
+     * @param collector
+     * @param food_field
+     */
+    static bool can_reach_food(Squarecell::Square const &collector,
+                               Squarecell::DistanceField const &food_field);
 
     /**
-     * @brief Moves the collector to \b food, if superposes with the
-     * food returns true and the state changes to LOADED
+     * @brief Drops the food carried by the collector, if any
      *
-     * @param food
-     * @return true if it reaches the food
      */
-    bool search_food(std::unique_ptr<Food> &food);
+    static void drop_food(AntColumns const &collectors, size_t i, FoodSet &foods);
 
     /**
-     * @brief Finds the nearest attainable food
+     * @brief Commits a food taken during a planned step (see Anthill::plan): the
+     * collector keeps the food of @p target and its new position if both are still
+     * available, otherwise it goes back to @p previous, empty
      *
+     * @param collectors
+     * @param i
      * @param foods
-     * @param[out] target
-     * @return true if it has found one
+     * @param target handle of the food taken
+     * @param previous position before the planned step, still recorded in the grid
+     * @return true if it has taken the food
      */
-    bool find_target_food(std::vector<std::unique_ptr<Food>> &foods, size_t &target);
+    static bool commit_take(AntColumns &collectors, size_t i, FoodSet &foods,
+                            SlotHandle target, Squarecell::Square const &previous);
 
-    void drop_food(std::vector<std::unique_ptr<Food>> &foods);
+    /**
+     * @brief Commits a food brought back to the anthill during a planned step (see
+     * Anthill::plan): if the collector can't keep its new position, it goes back to
+     * @p previous and still carries the food
+     *
+     * @param collectors
+     * @param i
+     * @param previous position before the planned step, still recorded in the grid
+     * @return true if the food is delivered
+     */
+    static bool commit_delivery(AntColumns &collectors, size_t i,
+                                Squarecell::Square const &previous);
 
     static bool
     test_if_inside_anthill_or_near_border_model(Squarecell::Square const &origin,
@@ -89,27 +169,53 @@ public:
                                         Squarecell::Square const &anthill);
 
     /**
-     * @brief Generates all the possible new positions / moves based on the origin
+     * @brief Moves policy for Squarecell::lee_algorithm: TOP-RIGHT, BOTTOM-RIGHT,
+     * TOP-LEFT, BOTTOM-LEFT (diagonal moves). Each move closes at most one cell in
+     * each axis, hence the Chebyshev distance as heuristic
+     *
+     */
+    struct Moves
+    {
+        static constexpr size_t n = 4;
+        static constexpr int x_shift[n]{1, 1, -1, -1};
+        static constexpr int y_shift[n]{1, -1, 1, -1};
+
+        static constexpr unsigned int heuristic(unsigned int dx, unsigned int dy)
+        {
+            return std::max(dx, dy);
+        }
+    };
+
+    /**
+     * @brief Appends all the possible new positions / moves based on the origin
      *
      * @param origin
-     * @return std::vector<Square>
+     * @param[out] moves
      */
-    static std::vector<Square> generate_moves(Squarecell::Square origin);
+    static void generate_moves(Squarecell::Square const &origin,
+                               std::vector<Squarecell::Square> &moves);
 
     /**
-     * @brief Creates a new pointed instance of Collector from its string
-     * representation
+     * @brief Appends to @p collectors the collector of its string representation
      *
      * @param line
-     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) same as
-     * graphic.h
-     * @return std::unique_ptr<Collector>
+     * @param collectors
      */
-    static std::unique_ptr<Collector> parse_line(std::string &line,
-                                                 unsigned int color_index);
+    static void parse_line(std::string_view line, AntColumns &collectors);
 
 private:
-    State_collector state;
+    /**
+     * @brief If a move leads to a food, it takes it
+     *
+     * @param[in,out] collector moved to the food taken
+     * @param foods
+     * @param food_field
+     * @param[out] target handle of the food taken
+     * @return true if it has taken a food
+     */
+    static bool take_adjacent_food(Squarecell::Square &collector, FoodSet &foods,
+                                   Squarecell::DistanceField const &food_field,
+                                   SlotHandle &target);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,268 @@
+/**
+ * @file config.cc
+ * @author Daniel Panero 100%, Andrea Diez 0%
+ * @version 0.1
+ * @date 2022-05-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <charconv>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "config.h"
+
+using std::string;
+using std::string_view;
+
+// Same as std::isspace in the "C" locale, without the lookup of the locale
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// ====================================================================================
+// File
+
+Config::File::File(string const &path)
+{
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(descriptor, &info) == 0)
+    {
+        size = info.st_size;
+        if (size == 0)
+        {
+            // An empty file can't be mapped, it simply has no lines
+            failed = false;
+        }
+        else
+        {
+            void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping != MAP_FAILED)
+            {
+                madvise(mapping, size, MADV_SEQUENTIAL);
+                data = static_cast<char const *>(mapping);
+                current = data;
+                failed = false;
+            }
+        }
+    }
+
+    close(descriptor);
+}
+
+Config::File::~File()
+{
+    if (data)
+    {
+        munmap(const_cast<char *>(data), size);
+    }
+}
+
+bool Config::File::fail() const { return failed; }
+
+string_view Config::File::next_line()
+{
+    char const *end = data + size;
+    while (current != end)
+    {
+        while (current != end && is_space(*current))
+        {
+            current++;
+        }
+        if (current == end)
+        {
+            break;
+        }
+
+        char const *begin = current;
+        auto newline = static_cast<char const *>(std::memchr(begin, '\n', end - begin));
+        char const *line_end = newline ? newline : end;
+        current = newline ? newline + 1 : end;
+
+        if (*begin != '#')
+        {
+            return string_view(begin, line_end - begin);
+        }
+    }
+
+    return string_view();
+}
+
+// ====================================================================================
+// Line
+
+Config::Line::Line(string_view line)
+    : current(line.data()), end(line.data() + line.size())
+{
+}
+
+bool Config::Line::fail() const { return failed; }
+
+bool Config::Line::skip_spaces()
+{
+    while (current != end && is_space(*current))
+    {
+        current++;
+    }
+
+    if (current == end)
+    {
+        failed = true;
+    }
+    return !failed;
+}
+
+Config::Line &Config::Line::operator>>(unsigned int &value)
+{
+    if (failed || !skip_spaces())
+    {
+        return *this;
+    }
+
+    bool negative = false;
+    if (*current == '+' || *current == '-')
+    {
+        negative = *current == '-';
+        current++;
+    }
+
+    unsigned int magnitude(0);
+    auto result = std::from_chars(current, end, magnitude);
+    if (result.ec == std::errc::invalid_argument)
+    {
+        value = 0;
+        failed = true;
+        return *this;
+    }
+
+    current = result.ptr;
+    if (result.ec == std::errc::result_out_of_range)
+    {
+        value = UINT_MAX;
+        failed = true;
+    }
+    else
+    {
+        value = negative ? 0u - magnitude : magnitude;
+    }
+
+    return *this;
+}
+
+Config::Line &Config::Line::operator>>(double &value)
+{
+    if (failed || !skip_spaces())
+    {
+        return *this;
+    }
+
+    // The number is delimited first with the grammar of the streams, which stops at
+    // the first character that can't be part of it ("1.5x" reads 1.5)
+    char const *begin = current;
+    char const *p = current;
+    if (*p == '+' || *p == '-')
+    {
+        p++;
+    }
+
+    char const *digits = p;
+    while (p != end && is_digit(*p))
+    {
+        p++;
+    }
+    bool mantissa = p != digits;
+    if (p != end && *p == '.')
+    {
+        p++;
+        char const *decimals = p;
+        while (p != end && is_digit(*p))
+        {
+            p++;
+        }
+        mantissa = mantissa || p != decimals;
+    }
+
+    bool valid = mantissa;
+    if (valid && p != end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        if (p != end && (*p == '+' || *p == '-'))
+        {
+            p++;
+        }
+        char const *exponent = p;
+        while (p != end && is_digit(*p))
+        {
+            p++;
+        }
+        // An exponent without digits makes the whole number invalid ("1e")
+        valid = p != exponent;
+    }
+
+    current = p;
+    if (!valid)
+    {
+        value = 0;
+        failed = true;
+        return *this;
+    }
+
+    // std::from_chars doesn't accept a leading '+'
+    auto result = std::from_chars(*begin == '+' ? begin + 1 : begin, p, value);
+    if (result.ec == std::errc::result_out_of_range)
+    {
+        // Rare enough to go through strtod, which tells an overflow from an underflow
+        double parsed = std::strtod(string(begin, p).c_str(), nullptr);
+        if (parsed == std::numeric_limits<double>::infinity() ||
+            parsed == -std::numeric_limits<double>::infinity())
+        {
+            value = parsed > 0 ? std::numeric_limits<double>::max()
+                               : -std::numeric_limits<double>::max();
+            failed = true;
+        }
+        else
+        {
+            value = parsed;
+        }
+    }
+
+    return *this;
+}
+
+Config::Line &Config::Line::operator>>(string_view &token)
+{
+    if (failed || !skip_spaces())
+    {
+        return *this;
+    }
+
+    char const *begin = current;
+    while (current != end && !is_space(*current))
+    {
+        current++;
+    }
+    token = string_view(begin, current - begin);
+
+    return *this;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file config.h
+ * @author Daniel Panero, Andrea Diez
+ * @brief Reader of the configuration files: the file is mapped in memory and its lines
+ * are tokenized in place, without copying them in strings nor going through the
+ * iostreams
+ * @version 0.1
+ * @date 2022-05-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Config
+{
+    /**
+     * @brief Configuration file mapped in memory (read only)
+     *
+     */
+    class File
+    {
+    public:
+        explicit File(std::string const &path);
+        ~File();
+
+        File(File const &) = delete;
+        File &operator=(File const &) = delete;
+
+        /**
+         * @brief Tells if the file couldn't be opened
+         *
+         */
+        bool fail() const;
+
+        /**
+         * @brief Gets the next non-empty line which isn't a comment (starting with
+         * '#'), without its leading spaces. The view points in the mapping, it stays
+         * valid as long as the file
+         *
+         * @return std::string_view an empty view at the end of the file
+         */
+        std::string_view next_line();
+
+    private:
+        char const *data = nullptr;
+        std::size_t size = 0;
+        bool failed = true;
+
+        // Start of the next line
+        char const *current = nullptr;
+    };
+
+    /**
+     * @brief Tokenizer of a line of the configuration, with the same results as an
+     * std::istringstream in the "C" locale: a value which can't be read is set to 0
+     * (to the maximum if it's too large) and all the following reads fail, leaving
+     * their values unchanged
+     *
+     */
+    class Line
+    {
+    public:
+        explicit Line(std::string_view line);
+
+        /**
+         * @brief Reads a decimal integer with an optional sign, a negative one wraps
+         * around as with std::strtoul
+         *
+         */
+        Line &operator>>(unsigned int &value);
+
+        /**
+         * @brief Reads a fixed or scientific decimal number (no "inf" nor "nan")
+         *
+         */
+        Line &operator>>(double &value);
+
+        /**
+         * @brief Reads the next word, it points in the line
+         *
+         */
+        Line &operator>>(std::string_view &token);
+
+        bool fail() const;
+        explicit operator bool() const { return !fail(); }
+
+    private:
+        /**
+         * @brief Skips the spaces before a token
+         *
+         * @return false if there's no token left, the read fails
+         */
+        bool skip_spaces();
+
+        char const *current;
+        char const *end;
+        bool failed = false;
+    };
+} // namespace Config
+
+#endif
@@ -9,91 +9,104 @@
  */
 
 #include <cmath>
-#include <memory>
-#include <sstream>
 #include <stdexcept>
+#include <string_view>
 
+#include "config.h"
 #include "message.h"
 #include "squarecell.h"
 
 #include "defensor.h"
 
-using std::istringstream;
 using std::string;
-using std::unique_ptr;
+using std::string_view;
 using std::vector;
 
+using Squarecell::Square;
+
+Squarecell::Engine Defensor::engine(Squarecell::LEE);
+
 // ====================================================================================
 // Initialization - Misc
 
-Defensor::Defensor(unsigned int x, unsigned int y, unsigned int age,
-                   unsigned int color_index)
-    : Ant{x, y, sizeD, age, color_index}
+void Defensor::insert(AntColumns &defensors, unsigned int x, unsigned int y,
+                      unsigned int age)
 {
-    Squarecell::test_square(*this);
-    add_to_grid();
-}
+    Square defensor{x, y, sizeD, true};
 
-Defensor::~Defensor()
-{
-    remove_from_grid();
-    undraw();
+    Squarecell::test_square(defensor);
+    add_to_grid(defensor);
+
+    defensors.push_back(x, y, age, EMPTY);
 }
 
-void Defensor::add_to_grid()
+void Defensor::add_to_grid(Square const &defensor)
 {
     unsigned int superposed_x(0);
     unsigned int superposed_y(0);
 
-    if (Squarecell::test_if_superposed_grid(*this, superposed_x, superposed_y))
+    if (Squarecell::test_if_superposed_grid(defensor, superposed_x, superposed_y))
     {
-        throw std::invalid_argument(
-            message::defensor_overlap(x, y, superposed_x, superposed_y));
+        throw std::invalid_argument(message::defensor_overlap(
+            defensor.x, defensor.y, superposed_x, superposed_y));
     }
 
-    Squarecell::add_square(*this);
+    Squarecell::add_square(defensor);
 }
 
-void Defensor::remove_from_grid() { Squarecell::remove_square(*this); }
-
-void Defensor::draw() { Squarecell::draw_plus_pattern(*this, get_color_index()); }
+void Defensor::draw(Graphic::Frame &frame, AntColumns const &defensors,
+                    unsigned int color_index)
+{
+    for (size_t i(0); i < defensors.size(); i++)
+    {
+        if (defensors.alive[i])
+        {
+            Squarecell::draw_plus_pattern(frame, defensors.get_square(i), color_index);
+        }
+    }
+}
 
-void Defensor::undraw() { Squarecell::undraw_square(*this); }
+void Defensor::set_engine(Squarecell::Engine engine) { Defensor::engine = engine; }
 
 // ====================================================================================
 // Simulation
 
-bool Defensor::step(Square &anthill_square)
+bool Defensor::step(AntColumns &defensors, size_t i, Square &anthill_square,
+                    Square const *planned)
 {
-    if (!increase_age())
-    {
-        return false;
-    }
-
-    remove_from_grid();
-    undraw();
+    auto defensor = defensors.get_square(i);
+    Squarecell::remove_square(defensor);
 
-    auto move =
-        Squarecell::lee_algorithm(*this, anthill_square, &Defensor::generate_moves,
-                                  &Defensor::test_if_confined_and_near_border);
+    auto move = planned && !Squarecell::test_if_superposed_grid(*planned)
+                    ? *planned
+                    : search_border(defensor, anthill_square);
 
-    x = move.x;
-    y = move.y;
+    defensor.x = move.x;
+    defensor.y = move.y;
+    defensors.set_position(i, defensor);
 
-    if (!Squarecell::test_if_completely_confined(*this, anthill_square))
+    if (!Squarecell::test_if_completely_confined(defensor, anthill_square))
     {
         return false;
     }
 
-    add_to_grid();
-    draw();
+    add_to_grid(defensor);
 
     return true;
 }
 
-bool Defensor::test_if_contact_collector(Squarecell::Square &collector_square)
+Squarecell::Square Defensor::search_border(Square const &origin, Square const &anthill)
 {
-    return Squarecell::test_if_border_touches(*this, collector_square);
+    return Squarecell::find_path<Moves>(
+        origin, anthill, [](Square const &origin, Square const &anthill)
+        { return test_if_confined_and_near_border(origin, anthill); },
+        engine);
+}
+
+bool Defensor::test_if_contact_collector(Square const &defensor_square,
+                                         Square const &collector_square)
+{
+    return Squarecell::test_if_border_touches(defensor_square, collector_square);
 }
 
 bool Defensor::test_if_confined_and_near_border(Square const &origin,
@@ -103,25 +116,21 @@ bool Defensor::test_if_confined_and_near_border(Square const &origin,
            Squarecell::test_if_border_touches(origin, anthill);
 }
 
-vector<Squarecell::Square> Defensor::generate_moves(Square origin)
+void Defensor::generate_moves(Square const &origin, vector<Square> &moves)
 {
-    // All the possible shifts combination: RIGHT, LEFT, TOP, BOTTOM
-    vector<int> x_shift{1, -1, 0, 0};
-    vector<int> y_shift{0, 0, 1, -1};
-
-    return Ant::generate_moves(origin, x_shift, y_shift);
+    Ant::generate_moves(origin, Moves::x_shift, Moves::y_shift, Moves::n, moves);
 }
 
-unique_ptr<Defensor> Defensor::parse_line(string &line, unsigned int color_index)
+void Defensor::parse_line(string_view line, AntColumns &defensors)
 {
     unsigned int x(0);
     unsigned int y(0);
     unsigned int age(0);
 
-    istringstream stream(line);
+    Config::Line stream(line);
     stream >> x;
     stream >> y;
     stream >> age;
 
-    return unique_ptr<Defensor>(new Defensor(x, y, age, color_index));
+    insert(defensors, x, y, age);
 }
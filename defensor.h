@@ -11,51 +11,84 @@
 #ifndef ANTS_DEFENSOR_H
 #define ANTS_DEFENSOR_H
 
-#include <memory>
+#include <string_view>
+#include <vector>
 
 #include "ants.h"
-#include "element.h"
+#include "constantes.h"
 #include "squarecell.h"
 
-class Defensor : public Ant
+/**
+ * @brief Behaviour of the defensors, which are the entries @p i of the AntColumns
+ * @p defensors of their anthill
+ *
+ */
+class Defensor
 {
 public:
+    static constexpr unsigned int side = sizeD;
+
     /**
-     * @brief Constructs a new Defensor instance
+     * @brief Appends a new defensor to @p defensors and adds it to the grid
      *
+     * @param defensors
      * @param x position of defensor in the x-axis
      * @param y position of defensor in the y-axis
      * @param age
-     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) same as
-     * graphic.h
      */
-    Defensor(unsigned int x, unsigned int y, unsigned int age,
-             unsigned int color_index);
-    ~Defensor() override;
+    static void insert(AntColumns &defensors, unsigned int x, unsigned int y,
+                       unsigned int age);
 
-    void add_to_grid() override;
-    void remove_from_grid() override;
+    /**
+     * @brief Checks that position in the grid is empty and either throw an error or
+     * fills the grid
+     *
+     * @param defensor
+     */
+    static void add_to_grid(Squarecell::Square const &defensor);
 
-    void draw() override;
-    void undraw() override;
+    /**
+     * @brief Appends the defensors alive of @p defensors to @p frame
+     *
+     */
+    static void draw(Graphic::Frame &frame, AntColumns const &defensors,
+                     unsigned int color_index);
 
     /**
      * @brief Advances one step the state of the defensor: it tries to remain inside
      * the anthill and near the border, when it fails to do so, it return false
      *
+     * @param defensors
+     * @param i
      * @param anthill_square
-     * @return false when outside or it is touching the border or died of old age
+     * @param planned next position searched in advance (see Anthill::plan_moves),
+     * used instead of a new search if it is still free
+     * @return false when outside or it is touching the border
      */
-    bool step(Squarecell::Square &anthill_square);
+    static bool step(AntColumns &defensors, size_t i,
+                     Squarecell::Square &anthill_square,
+                     Squarecell::Square const *planned = nullptr);
+
+    /**
+     * @brief Returns the first move of \b step from @p origin toward the border of
+     * @p anthill, @p origin must not be in the grid. It only reads the grid
+     *
+     * @param origin
+     * @param anthill
+     */
+    static Squarecell::Square search_border(Squarecell::Square const &origin,
+                                            Squarecell::Square const &anthill);
 
     /**
      * @brief Tests if the collector is in contact with the defensor
      *
+     * @param defensor_square
      * @param collector_square
      * @return true
      * @return false
      */
-    bool test_if_contact_collector(Squarecell::Square &collector_square);
+    static bool test_if_contact_collector(Squarecell::Square const &defensor_square,
+                                          Squarecell::Square const &collector_square);
 
     /**
      * @brief Tests that the origin is completly confined and near the border
@@ -68,23 +101,50 @@ public:
                                                  Squarecell::Square const &anthill);
 
     /**
-     * @brief Generates all the possible new positions / moves based on the origin
+     * @brief Moves policy for Squarecell::lee_algorithm: RIGHT, LEFT, TOP, BOTTOM
+     * (4-neighbourhood). Each move closes at most one cell in only one axis, hence
+     * the Manhattan distance as heuristic
+     *
+     */
+    struct Moves
+    {
+        static constexpr size_t n = 4;
+        static constexpr int x_shift[n]{1, -1, 0, 0};
+        static constexpr int y_shift[n]{0, 0, 1, -1};
+
+        static constexpr unsigned int heuristic(unsigned int dx, unsigned int dy)
+        {
+            return dx + dy;
+        }
+    };
+
+    /**
+     * @brief Selects the search engine used by all the defensors (LEE by default)
+     *
+     * @param engine
+     */
+    static void set_engine(Squarecell::Engine engine);
+
+
+    /**
+     * @brief Appends all the possible new positions / moves based on the origin
      *
      * @param origin
-     * @return std::vector<Square>
+     * @param[out] moves
      */
-    static std::vector<Square> generate_moves(Squarecell::Square origin);
+    static void generate_moves(Squarecell::Square const &origin,
+                               std::vector<Squarecell::Square> &moves);
 
     /**
-     * @brief Creates a new pointed instance of Defensor from its string representation
+     * @brief Appends to @p defensors the defensor of its string representation
      *
      * @param line
-     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) same as
-     * graphic.h
-     * @return std::unique_ptr<Defensor>
+     * @param defensors
      */
-    static std::unique_ptr<Defensor> parse_line(std::string &line,
-                                                unsigned int color_index);
+    static void parse_line(std::string_view line, AntColumns &defensors);
+
+private:
+    static Squarecell::Engine engine;
 };
 
 #endif
\ No newline at end of file
@@ -46,8 +46,13 @@ public:
      * @return std::string
      */
     virtual std::string get_as_string() = 0;
-    virtual void draw() = 0;
-    virtual void undraw() = 0;
+
+    /**
+     * @brief Appends the element to @p frame
+     *
+     * @param frame
+     */
+    virtual void draw(Graphic::Frame &frame) = 0;
 
 private:
     /**
@@ -8,19 +8,25 @@
  *
  */
 
+#include <algorithm>
 #include <iostream>
-#include <sstream>
 #include <stdexcept>
+#include <string_view>
+#include <vector>
 
+#include "config.h"
 #include "element.h"
 #include "message.h"
 #include "squarecell.h"
 
 #include "food.h"
 
-using std::istringstream;
 using std::string;
+using std::string_view;
 using std::unique_ptr;
+using std::vector;
+
+using Squarecell::Square;
 
 Food::Food(unsigned int x, unsigned int y) : Element{x, y, 1, true, 0}
 {
@@ -40,20 +46,138 @@ void Food::add_to_grid()
 
 void Food::remove_from_grid() { Squarecell::remove_square(*this); }
 
-void Food::draw() { Squarecell::draw_as_diamond(*this, "white"); }
-
-void Food::undraw() { Squarecell::undraw_square(*this); }
+void Food::draw(Graphic::Frame &frame)
+{
+    Squarecell::draw_as_diamond(frame, *this, Graphic::white);
+}
 
 string Food::get_as_string() { return std::to_string(x) + " " + std::to_string(y); }
 
-unique_ptr<Food> Food::parse_line(string &line)
+unique_ptr<Food> Food::parse_line(string_view line)
 {
     unsigned int x(0);
     unsigned int y(0);
 
-    istringstream stream(line);
+    Config::Line stream(line);
     stream >> x;
     stream >> y;
 
     return unique_ptr<Food>(new Food(x, y));
 }
+
+// ====================================================================================
+// FoodSet
+
+SlotHandle FoodSet::insert(unique_ptr<Food> food)
+{
+    resize();
+
+    auto square = food->get_as_square();
+    auto handle = foods.insert(std::move(food));
+
+    get_bucket(square.x, square.y)
+        .push_back({square.x, square.y, next_order++, handle});
+
+    return handle;
+}
+
+unique_ptr<Food> FoodSet::erase(SlotHandle handle)
+{
+    auto square = (*foods.get(handle))->get_as_square();
+
+    auto &bucket = get_bucket(square.x, square.y);
+    for (auto &entry : bucket)
+    {
+        if (entry.handle == handle)
+        {
+            entry = bucket.back();
+            bucket.pop_back();
+            break;
+        }
+    }
+
+    return foods.erase(handle);
+}
+
+Food *FoodSet::get(SlotHandle handle)
+{
+    auto *food = foods.get(handle);
+    return food ? food->get() : nullptr;
+}
+
+bool FoodSet::find_superposed(Square const &square, SlotHandle &handle) const
+{
+    if (width == 0)
+    {
+        return false;
+    }
+
+    unsigned int x_min = Squarecell::get_coordinate_x(square);
+    unsigned int y_min = Squarecell::get_coordinate_y(square);
+    unsigned int x_max = x_min + square.side - 1;
+    unsigned int y_max = y_min + square.side - 1;
+
+    unsigned int i_max = std::min(x_max / block, width - 1);
+    unsigned int j_max = std::min(y_max / block, width - 1);
+
+    Entry const *first = nullptr;
+    for (unsigned int j(y_min / block); j <= j_max; j++)
+    {
+        for (unsigned int i(x_min / block); i <= i_max; i++)
+        {
+            for (auto const &entry : buckets[j * width + i])
+            {
+                if (entry.x >= x_min && entry.x <= x_max && entry.y >= y_min &&
+                    entry.y <= y_max && (!first || entry.order < first->order))
+                {
+                    first = &entry;
+                }
+            }
+        }
+    }
+
+    if (first)
+    {
+        handle = first->handle;
+    }
+
+    return first != nullptr;
+}
+
+void FoodSet::clear()
+{
+    foods.clear();
+    for (auto &bucket : buckets)
+    {
+        bucket.clear();
+    }
+    next_order = 0;
+}
+
+size_t FoodSet::size() const { return foods.size(); }
+
+vector<FoodSet::Entry> &FoodSet::get_bucket(unsigned int x, unsigned int y)
+{
+    return buckets[(y / block) * width + x / block];
+}
+
+void FoodSet::resize()
+{
+    unsigned int new_width = (Squarecell::get_grid_size() + block - 1) / block;
+    if (width == new_width)
+    {
+        return;
+    }
+
+    width = new_width;
+    buckets.assign(width * width, {});
+
+    // The foods already inserted are indexed again in the same order
+    next_order = 0;
+    for (auto it = foods.begin(); it != foods.end(); ++it)
+    {
+        auto square = (*it)->get_as_square();
+        get_bucket(square.x, square.y)
+            .push_back({square.x, square.y, next_order++, it.handle()});
+    }
+}
\ No newline at end of file
@@ -12,11 +12,15 @@
 #define ENTITIES_FOOD_H
 
 #include <memory>
+#include <string_view>
+#include <vector>
 
+#include "allocation.h"
 #include "element.h"
+#include "slotmap.h"
 #include "squarecell.h"
 
-class Food : public Element
+class Food : public Element, public Allocation::Pooled<Food>
 {
 public:
     /**
@@ -31,12 +35,78 @@ public:
     void add_to_grid();
     void remove_from_grid();
 
-    void draw() override;
-    void undraw() override;
+    void draw(Graphic::Frame &frame) override;
 
     std::string get_as_string() override;
 
-    static std::unique_ptr<Food> parse_line(std::string &line);
+    static std::unique_ptr<Food> parse_line(std::string_view line);
+};
+
+/**
+ * @brief Foods of the simulation, stored in a SlotMap (iterated in order of
+ * insertion) and indexed by position in a grid of buckets of block x block cells. It
+ * finds the foods around a position without going through all of them
+ *
+ */
+class FoodSet
+{
+public:
+    static constexpr unsigned int block = 8;
+
+    using iterator = SlotMap<std::unique_ptr<Food>>::iterator;
+    using const_iterator = SlotMap<std::unique_ptr<Food>>::const_iterator;
+
+    SlotHandle insert(std::unique_ptr<Food> food);
+    std::unique_ptr<Food> erase(SlotHandle handle);
+
+    /**
+     * @brief Returns the food of @p handle or nullptr if it has been erased
+     *
+     */
+    Food *get(SlotHandle handle);
+
+    /**
+     * @brief Finds the first food (in order of insertion) superposing @p square
+     *
+     * @param square
+     * @param[out] handle
+     * @return true if there is one
+     */
+    bool find_superposed(Squarecell::Square const &square, SlotHandle &handle) const;
+
+    void clear();
+    size_t size() const;
+
+    iterator begin() { return foods.begin(); }
+    iterator end() { return foods.end(); }
+    const_iterator begin() const { return foods.begin(); }
+    const_iterator end() const { return foods.end(); }
+
+private:
+    struct Entry
+    {
+        unsigned int x;
+        unsigned int y;
+
+        // Rank of insertion, for the ties
+        unsigned long long order;
+        SlotHandle handle;
+    };
+
+    std::vector<Entry> &get_bucket(unsigned int x, unsigned int y);
+
+    /**
+     * @brief Adapts the buckets to the size of the world, it has to be called before
+     * each insertion
+     *
+     */
+    void resize();
+
+    SlotMap<std::unique_ptr<Food>> foods;
+
+    std::vector<std::vector<Entry>> buckets;
+    unsigned int width = 0;
+    unsigned long long next_order = 0;
 };
 
 #endif
\ No newline at end of file
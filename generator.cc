@@ -19,12 +19,13 @@ using std::istringstream;
 using std::string;
 using std::vector;
 
+Squarecell::Engine Generator::engine(Squarecell::LEE);
+
 // ====================================================================================
 // Initialization - Misc
 
-Generator::Generator(unsigned int x, unsigned int y, unsigned int age,
-                     unsigned int color_index)
-    : Ant{x, y, sizeG, age, color_index}
+Generator::Generator(unsigned int x, unsigned int y, unsigned int color_index)
+    : Ant{x, y, sizeG, color_index}
 {
     Squarecell::test_square(*this);
     add_to_grid();
@@ -33,7 +34,6 @@ Generator::Generator(unsigned int x, unsigned int y, unsigned int age,
 Generator::~Generator()
 {
     remove_from_grid();
-    undraw();
 }
 
 void Generator::add_to_grid()
@@ -52,43 +52,41 @@ void Generator::add_to_grid()
 
 void Generator::remove_from_grid() { Squarecell::remove_square(*this); }
 
-void Generator::draw() { Squarecell::draw_filled(*this, get_color_index()); }
-
-void Generator::undraw() { Squarecell::undraw_square(*this); }
+void Generator::draw(Graphic::Frame &frame)
+{
+    Squarecell::draw_filled(frame, *this, get_color_index());
+}
 
 string Generator::get_as_string()
 {
     return std::to_string(x) + " " + std::to_string(y);
 }
 
+void Generator::set_engine(Squarecell::Engine engine) { Generator::engine = engine; }
+
 // ====================================================================================
 // Simulation
 
 bool Generator::step(const Square &anthill)
 {
     remove_from_grid();
-    undraw();
 
-    auto move =
-        Squarecell::lee_algorithm(*this, anthill, &Generator::generate_moves,
-                                  &Generator::test_if_confined_and_not_near_border);
+    auto move = Squarecell::find_path<Moves>(
+        *this, anthill, [](Square const &origin, Square const &anthill)
+        { return test_if_confined_and_not_near_border(origin, anthill); },
+        engine);
 
     x = move.x;
     y = move.y;
 
     add_to_grid();
-    draw();
 
     return Generator::test_if_confined_and_not_near_border(*this, anthill);
 }
 
-vector<Squarecell::Square> Generator::generate_moves(Square origin)
+void Generator::generate_moves(Square const &origin, vector<Square> &moves)
 {
-    // All the possible shifts combination: RIGHT, LEFT, TOP, BOTTOM, TOP-RIGHT...
-    vector<int> x_shift{1, -1, 0, 0, 1, 1, -1, -1};
-    vector<int> y_shift{0, 0, 1, -1, 1, -1, 1, -1};
-
-    return Ant::generate_moves(origin, x_shift, y_shift);
+    Ant::generate_moves(origin, Moves::x_shift, Moves::y_shift, Moves::n, moves);
 }
 
 bool Generator::test_if_confined_and_not_near_border(Square const &origin,
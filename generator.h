@@ -11,6 +11,8 @@
 #ifndef ANTS_GENERATOR_H
 #define ANTS_GENERATOR_H
 
+#include <algorithm>
+
 #include "ants.h"
 
 class Generator : public Ant
@@ -21,19 +23,16 @@ public:
      *
      * @param x position of generator in the x-axis
      * @param y position of generator in the y-axis
-     * @param age
      * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) same as
      * graphic.h
      */
-    Generator(unsigned int x, unsigned int y, unsigned int age,
-              unsigned int color_index);
+    Generator(unsigned int x, unsigned int y, unsigned int color_index);
     ~Generator() override;
 
     void add_to_grid() override;
     void remove_from_grid() override;
 
-    void draw() override;
-    void undraw() override;
+    void draw(Graphic::Frame &frame) override;
 
     std::string get_as_string() override;
 
@@ -47,12 +46,39 @@ public:
     bool step(const Squarecell::Square &anthill);
 
     /**
-     * @brief Generates all the possible new positions / moves based on the origin
+     * @brief Moves policy for Squarecell::lee_algorithm: RIGHT, LEFT, TOP, BOTTOM,
+     * TOP-RIGHT... (8-neighbourhood). Each move closes at most one cell in each
+     * axis, hence the Chebyshev distance as heuristic
+     *
+     */
+    struct Moves
+    {
+        static constexpr size_t n = 8;
+        static constexpr int x_shift[n]{1, -1, 0, 0, 1, 1, -1, -1};
+        static constexpr int y_shift[n]{0, 0, 1, -1, 1, -1, 1, -1};
+
+        static constexpr unsigned int heuristic(unsigned int dx, unsigned int dy)
+        {
+            return std::max(dx, dy);
+        }
+    };
+
+    /**
+     * @brief Selects the search engine used by all the generators (LEE by default)
+     *
+     * @param engine
+     */
+    static void set_engine(Squarecell::Engine engine);
+
+
+    /**
+     * @brief Appends all the possible new positions / moves based on the origin
      *
      * @param origin
-     * @return std::vector<Square>
+     * @param[out] moves
      */
-    static std::vector<Squarecell::Square> generate_moves(Squarecell::Square origin);
+    static void generate_moves(Squarecell::Square const &origin,
+                               std::vector<Squarecell::Square> &moves);
 
     /**
      * @brief Returns true if origin is inside of square anthill and it doesn't touch
@@ -66,6 +92,9 @@ public:
     static bool
     test_if_confined_and_not_near_border(Squarecell::Square const &origin,
                                          Squarecell::Square const &anthill);
+
+private:
+    static Squarecell::Engine engine;
 };
 
 #endif
\ No newline at end of file
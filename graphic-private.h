@@ -19,9 +19,10 @@
 
 /**
  * @brief Creates a new Cairo surface, sets as the current surface and returns the
- * pointer to it
+ * pointer to it. The scale factor is reduced for big worlds, so that the surface
+ * keeps a reasonable size in memory
  *
- * @param size size of the surface
+ * @param size size of the surface (number of cells)
  * @return Cairo::RefPtr<Cairo::ImageSurface>
  */
 Cairo::RefPtr<Cairo::ImageSurface> create_surface(unsigned int size);
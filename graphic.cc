@@ -9,7 +9,13 @@
  *
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include <cairomm/matrix.h>
@@ -19,6 +25,7 @@
 
 #include "graphic-private.h"
 #include "graphic.h"
+#include "raster.h"
 
 using std::string;
 
@@ -32,9 +39,22 @@ constexpr double cell_size(1);
 /* The scale factor controls "image quality / resolution". As we increase it, the
  * quality improves, but rendering will be slower. 1/scale_factor correspondes to 1
  * pixel in the surface */
-constexpr double scale_factor(7);
-constexpr double grid_linewidth(1 / scale_factor);
-constexpr double thick_border_linewidth(2 * 1 / scale_factor);
+constexpr double max_scale_factor(7);
+/* Maximal width / height in pixels of a surface: for big worlds the scale factor is
+ * reduced, so that the surfaces still fit in memory (a 4096x4096 world at scale 7
+ * would need more than 3 GB per surface) */
+constexpr double max_surface_size(4096);
+/* Below this scale factor, the grid mesh would cover the whole surface */
+constexpr double min_scale_factor_grid_mesh(3);
+/* The changes of a frame are tracked on tiles of dirty_tile_size x dirty_tile_size
+ * cells: smaller tiles redraw less cells but need more clipped draws */
+constexpr unsigned int dirty_tile_size(8);
+
+static double scale_factor(max_scale_factor);
+static double grid_linewidth(1 / scale_factor);
+static double thick_border_linewidth(2 * 1 / scale_factor);
+
+static Graphic::Renderer renderer(Graphic::CAIRO);
 
 const std::vector<string> dark_colors{"red",    "green",   "blue",
                                       "yellow", "magenta", "cyan"};
@@ -52,6 +72,11 @@ auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, 0, 0);
 
 Cairo::RefPtr<Cairo::ImageSurface> create_surface(unsigned int size)
 {
+    scale_factor =
+        std::max(1.0, std::min(max_scale_factor, std::floor(max_surface_size / size)));
+    grid_linewidth = 1 / scale_factor;
+    thick_border_linewidth = 2 * 1 / scale_factor;
+
     surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, size * scale_factor,
                                           size * scale_factor);
     return surface;
@@ -101,6 +126,11 @@ Cairo::RefPtr<Cairo::Context> create_default_cc()
  */
 string get_color(unsigned int color_index, bool light = false)
 {
+    if (color_index == Graphic::white)
+    {
+        return "white";
+    }
+
     if (light)
     {
         return light_colors[color_index % dark_colors.size()];
@@ -108,6 +138,599 @@ string get_color(unsigned int color_index, bool light = false)
     return dark_colors[color_index % dark_colors.size()];
 }
 
+/**
+ * @brief Creates the diagonal pattern: one square 2x2 |X O||O X| where X has color @p
+ * color_index and O a lighter version of @p color_index
+ *
+ * @param color_index
+ * @param parity
+ * @return Cairo::RefPtr<Cairo::SurfacePattern>
+ */
+Cairo::RefPtr<Cairo::SurfacePattern> create_diagonal_pattern(unsigned int color_index,
+                                                             unsigned int parity)
+{
+    RGBA dark_color(get_color(color_index));
+    RGBA light_color(get_color(color_index, true));
+
+    auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, 2, 2);
+    auto cc = Cairo::Context::create(surface);
+
+    if (parity == 1)
+    {
+        Cairo::Matrix ctm{1, 0, 0, -1, 0, 2};
+        cc->set_matrix(ctm);
+    }
+
+    set_source_rgba(cc, dark_color);
+    cc->rectangle(0, 0, cell_size, cell_size);
+    cc->rectangle(cell_size, cell_size, cell_size, cell_size);
+    cc->fill();
+
+    set_source_rgba(cc, light_color);
+    cc->rectangle(cell_size, 0, cell_size, cell_size);
+    cc->rectangle(0, cell_size, cell_size, cell_size);
+    cc->fill();
+
+    surface->flush();
+
+    auto pattern = Cairo::SurfacePattern::create(surface);
+    pattern->set_filter(Cairo::Filter::FILTER_NEAREST);
+    pattern->set_extend(Cairo::Extend::EXTEND_REPEAT);
+
+    return pattern;
+}
+
+// ====================================================================================
+// Frame drawing
+
+/**
+ * @brief Colors of the frames, built once instead of at each primitive: the dark /
+ * light versions of the 6 colors and their diagonal patterns for both parities
+ *
+ */
+struct Palette
+{
+    RGBA white;
+    RGBA dark[6];
+    RGBA light[6];
+    Cairo::RefPtr<Cairo::SurfacePattern> diagonal[6][2];
+};
+
+static Palette const &get_palette()
+{
+    static Palette const palette = []
+    {
+        Palette palette;
+        palette.white = RGBA(get_color(Graphic::white));
+        for (unsigned int i(0); i < std::size(palette.dark); i++)
+        {
+            palette.dark[i] = RGBA(get_color(i));
+            palette.light[i] = RGBA(get_color(i, true));
+            palette.diagonal[i][0] = create_diagonal_pattern(i, 0);
+            palette.diagonal[i][1] = create_diagonal_pattern(i, 1);
+        }
+        return palette;
+    }();
+
+    return palette;
+}
+
+/**
+ * @brief Draws @p frame with the context @p cc. The consecutive primitives with the
+ * same shape and color (e.g: the foods, the collectors of an anthill) are drawn as a
+ * single path with one fill / stroke: the colors are opaque, so it gives the same
+ * result as drawing them one by one with the corresponding draw_*. The patterns are
+ * drawn in two passes (one per parity for the diagonal one, the background then the
+ * plus for the other), so two of them which superpose could end up in the wrong
+ * order: it never happens with a frame of the model, where the ants can't superpose
+ *
+ * @param cc context created by \b create_default_cc
+ * @param frame
+ */
+static void draw_batched(Cairo::RefPtr<Cairo::Context> const &cc,
+                         Graphic::Frame const &frame)
+{
+    auto const &palette = get_palette();
+
+    for (size_t begin(0), end(0); begin < frame.size(); begin = end)
+    {
+        auto const &first = frame[begin];
+        end = begin + 1;
+        while (end < frame.size() && frame[end].shape == first.shape &&
+               frame[end].color_index == first.color_index)
+        {
+            end++;
+        }
+
+        bool white(first.color_index == Graphic::white);
+        unsigned int color(white ? 0 : first.color_index % std::size(palette.dark));
+        RGBA const &dark_color(white ? palette.white : palette.dark[color]);
+        RGBA const &light_color(white ? palette.white : palette.light[color]);
+
+        switch (first.shape)
+        {
+        case Graphic::DIAMOND:
+            for (size_t i(begin); i < end; i++)
+            {
+                double x(frame[i].x), y(frame[i].y), side(frame[i].side);
+                cc->move_to(x + side / 2, y);
+                cc->line_to(x + side, y + side / 2);
+                cc->line_to(x + side / 2, y + side);
+                cc->line_to(x, y + side / 2);
+            }
+            set_source_rgba(cc, dark_color);
+            cc->fill();
+            break;
+
+        case Graphic::THICK_BORDER:
+            for (size_t i(begin); i < end; i++)
+            {
+                cc->rectangle(frame[i].x + cell_size / 2, frame[i].y + cell_size / 2,
+                              frame[i].side - cell_size, frame[i].side - cell_size);
+            }
+            set_source_rgba(cc, dark_color);
+            cc->set_line_width(thick_border_linewidth);
+            cc->stroke();
+            break;
+
+        case Graphic::FILLED:
+            for (size_t i(begin); i < end; i++)
+            {
+                cc->rectangle(frame[i].x, frame[i].y, frame[i].side, frame[i].side);
+            }
+            set_source_rgba(cc, dark_color);
+            cc->fill();
+            break;
+
+        case Graphic::DIAGONAL_PATTERN:
+            // One path per parity, as they don't have the same pattern
+            for (unsigned int parity(0); parity < 2; parity++)
+            {
+                bool found(false);
+                for (size_t i(begin); i < end; i++)
+                {
+                    if ((frame[i].x - frame[i].y) % 2 == parity)
+                    {
+                        cc->rectangle(frame[i].x, frame[i].y, frame[i].side,
+                                      frame[i].side);
+                        found = true;
+                    }
+                }
+
+                if (found)
+                {
+                    if (white)
+                    {
+                        set_source_rgba(cc, palette.white);
+                    }
+                    else
+                    {
+                        cc->set_source(palette.diagonal[color][parity]);
+                    }
+                    cc->fill();
+                }
+            }
+            break;
+
+        case Graphic::PLUS_PATTERN:
+            for (size_t i(begin); i < end; i++)
+            {
+                cc->rectangle(frame[i].x, frame[i].y, frame[i].side, frame[i].side);
+            }
+            set_source_rgba(cc, light_color);
+            cc->fill();
+
+            for (size_t i(begin); i < end; i++)
+            {
+                double x(frame[i].x), y(frame[i].y), side(frame[i].side);
+                double x_center = x + (side - cell_size) / 2;
+                double y_center = y + (side - cell_size) / 2;
+                cc->rectangle(x_center, y, cell_size, side);
+                cc->rectangle(x, y_center, side, cell_size);
+            }
+            set_source_rgba(cc, dark_color);
+            cc->fill();
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Converts @p color to a pixel of an ARGB32 surface (premultiplied alpha), with
+ * the same rounding as Cairo for the 8-bit colors
+ *
+ */
+static uint32_t to_pixel(RGBA const &color)
+{
+    auto channel = [&](double value)
+    { return uint32_t(std::lround(value * color.get_alpha() * 255)); };
+
+    return channel(1) << 24 | channel(color.get_red()) << 16 |
+           channel(color.get_green()) << 8 | channel(color.get_blue());
+}
+
+/**
+ * @brief Rasterizer of the PIXELS renderer, ready to draw on the pixels of the current
+ * surface (pending Cairo drawings are flushed first). It is built again when the scale
+ * factor changes
+ *
+ */
+static Raster &get_raster()
+{
+    static std::unique_ptr<Raster> raster;
+
+    if (!raster || raster->get_scale() != scale_factor)
+    {
+        auto const &palette = get_palette();
+        Raster::Colors colors;
+        colors.white = to_pixel(palette.white);
+        for (unsigned int i(0); i < std::size(colors.dark); i++)
+        {
+            colors.dark[i] = to_pixel(palette.dark[i]);
+            colors.light[i] = to_pixel(palette.light[i]);
+        }
+        double border_width(thick_border_linewidth * scale_factor);
+        raster = std::make_unique<Raster>(scale_factor, border_width, colors);
+    }
+
+    surface->flush();
+    raster->set_target(reinterpret_cast<uint32_t *>(surface->get_data()),
+                       surface->get_stride() / sizeof(uint32_t), surface->get_width(),
+                       surface->get_height());
+    return *raster;
+}
+
+void Graphic::set_renderer(Renderer new_renderer) { renderer = new_renderer; }
+
+void Graphic::draw_frame(Frame const &frame)
+{
+    if (renderer == PIXELS)
+    {
+        auto &raster = get_raster();
+        raster.clear();
+        for (auto const &primitive : frame)
+        {
+            raster.draw(primitive);
+        }
+
+        surface->mark_dirty();
+        return;
+    }
+
+    // A single context for the whole frame
+    auto cc = create_default_cc();
+
+    cc->save();
+    cc->set_operator(Cairo::Operator::OPERATOR_CLEAR);
+    cc->paint();
+    cc->restore();
+
+    draw_batched(cc, frame);
+
+    surface->flush();
+}
+
+// ====================================================================================
+// Incremental drawing
+
+/**
+ * @brief Consecutive dirty tiles [first, last] of a row of tiles
+ *
+ */
+struct DirtyRun
+{
+    unsigned int row;
+    unsigned int first;
+    unsigned int last;
+};
+
+static bool primitive_less(Graphic::Primitive const &a, Graphic::Primitive const &b)
+{
+    return std::tie(a.x, a.y, a.side, a.shape, a.color_index) <
+           std::tie(b.x, b.y, b.side, b.shape, b.color_index);
+}
+
+/**
+ * @brief Sorts the indices of @p primitives by primitive, then by index
+ *
+ */
+static void sort_indices(Graphic::Frame const &primitives,
+                         std::vector<unsigned int> &indices)
+{
+    indices.resize(primitives.size());
+    std::iota(indices.begin(), indices.end(), 0u);
+    std::sort(indices.begin(), indices.end(),
+              [&](unsigned int a, unsigned int b)
+              {
+                  return primitive_less(primitives[a], primitives[b]) ||
+                         (!primitive_less(primitives[b], primitives[a]) && a < b);
+              });
+}
+
+/**
+ * @brief Calls @p function(first_column, last_column, first_row, last_row) with the
+ * tiles covered by @p primitive: the tiles of its square, but only the ones of its
+ * ring of cells for a border, whose inside isn't drawn (unless its line is wider than
+ * a cell)
+ *
+ */
+template <typename Function>
+static void for_each_covered_tiles(Graphic::Primitive const &primitive,
+                                   unsigned int n_tiles, Function function)
+{
+    auto cover = [&](unsigned int x, unsigned int y, unsigned int width,
+                     unsigned int height)
+    {
+        unsigned int last_tile(n_tiles - 1);
+        function(std::min(x / dirty_tile_size, last_tile),
+                 std::min((x + width - 1) / dirty_tile_size, last_tile),
+                 std::min(y / dirty_tile_size, last_tile),
+                 std::min((y + height - 1) / dirty_tile_size, last_tile));
+    };
+
+    unsigned int x(primitive.x);
+    unsigned int y(primitive.y);
+    unsigned int side(primitive.side);
+    if (side == 0)
+    {
+        return;
+    }
+
+    if (primitive.shape == Graphic::THICK_BORDER && thick_border_linewidth > cell_size)
+    {
+        // At scale 1, the line of the border overflows its cells by one pixel
+        unsigned int margin_x(std::min(x, 1u));
+        unsigned int margin_y(std::min(y, 1u));
+        cover(x - margin_x, y - margin_y, side + margin_x + 1, side + margin_y + 1);
+    }
+    else if (primitive.shape == Graphic::THICK_BORDER && side > 2)
+    {
+        cover(x, y, side, 1);
+        cover(x, y + side - 1, side, 1);
+        cover(x, y + 1, 1, side - 2);
+        cover(x + side - 1, y + 1, 1, side - 2);
+    }
+    else
+    {
+        cover(x, y, side, side);
+    }
+}
+
+void Graphic::draw_frame_changes(Frame const &previous, Frame const &frame,
+                                 std::vector<Area> &dirty)
+{
+    // Kept between the frames, so that a frame doesn't allocate memory
+    static Frame changes, run_frame;
+    static std::vector<unsigned int> previous_order, frame_order;
+    static std::vector<unsigned int> partners, tails, links;
+    static std::vector<bool> kept;
+    static std::vector<unsigned int> tiles;
+    static std::vector<DirtyRun> runs;
+    static std::vector<std::pair<unsigned int, unsigned int>> hits;
+
+    dirty.clear();
+
+    unsigned int size(surface->get_width() / scale_factor);
+    unsigned int n_tiles((size + dirty_tile_size - 1) / dirty_tile_size);
+    if (n_tiles == 0)
+    {
+        return;
+    }
+
+    /* The primitives of the frame are paired with the equal ones of the previous
+     * frame, the ones without a partner are changes */
+    constexpr unsigned int no_partner(UINT_MAX);
+    sort_indices(previous, previous_order);
+    sort_indices(frame, frame_order);
+
+    changes.clear();
+    partners.assign(frame.size(), no_partner);
+    for (size_t p(0), f(0); p < previous_order.size() || f < frame_order.size();)
+    {
+        if (f == frame_order.size() ||
+            (p < previous_order.size() &&
+             primitive_less(previous[previous_order[p]], frame[frame_order[f]])))
+        {
+            changes.push_back(previous[previous_order[p++]]);
+        }
+        else if (p == previous_order.size() ||
+                 primitive_less(frame[frame_order[f]], previous[previous_order[p]]))
+        {
+            changes.push_back(frame[frame_order[f++]]);
+        }
+        else
+        {
+            partners[frame_order[f++]] = previous_order[p++];
+        }
+    }
+
+    /* Two equal primitives can still be drawn in another order than before, e.g. when
+     * an ant moves exactly where another ant of its anthill was. The pairs kept are a
+     * longest increasing subsequence of the partners in the order of the frame: they
+     * are drawn in the same order in both frames, so a cell covered only by them looks
+     * the same, the other pairs are changes */
+    tails.clear();
+    links.assign(frame.size(), no_partner);
+    for (unsigned int i(0); i < frame.size(); i++)
+    {
+        if (partners[i] == no_partner)
+        {
+            continue;
+        }
+
+        auto tail = std::lower_bound(tails.begin(), tails.end(), partners[i],
+                                     [](unsigned int tail, unsigned int partner)
+                                     { return partners[tail] < partner; });
+        if (tail != tails.begin())
+        {
+            links[i] = *(tail - 1);
+        }
+        if (tail == tails.end())
+        {
+            tails.push_back(i);
+        }
+        else
+        {
+            *tail = i;
+        }
+    }
+
+    kept.assign(frame.size(), false);
+    for (unsigned int i(tails.empty() ? no_partner : tails.back()); i != no_partner;
+         i = links[i])
+    {
+        kept[i] = true;
+    }
+    for (unsigned int i(0); i < frame.size(); i++)
+    {
+        if (partners[i] != no_partner && !kept[i])
+        {
+            changes.push_back(previous[partners[i]]);
+            changes.push_back(frame[i]);
+        }
+    }
+
+    tiles.clear();
+    for (auto const &primitive : changes)
+    {
+        for_each_covered_tiles(
+            primitive, n_tiles,
+            [&](unsigned int first_column, unsigned int last_column,
+                unsigned int first_row, unsigned int last_row)
+            {
+                for (unsigned int row(first_row); row <= last_row; row++)
+                {
+                    for (unsigned int column(first_column); column <= last_column;
+                         column++)
+                    {
+                        tiles.push_back(row * n_tiles + column);
+                    }
+                }
+            });
+    }
+    std::sort(tiles.begin(), tiles.end());
+    tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+
+    if (tiles.empty())
+    {
+        return;
+    }
+
+    // Redrawing most of the tiles one by one would be slower than the whole surface
+    if (tiles.size() * 2 > n_tiles * n_tiles)
+    {
+        draw_frame(frame);
+        dirty.push_back({0, 0, size, size});
+        return;
+    }
+
+    runs.clear();
+    for (auto tile : tiles)
+    {
+        unsigned int row(tile / n_tiles);
+        unsigned int column(tile % n_tiles);
+        if (!runs.empty() && runs.back().row == row && runs.back().last + 1 == column)
+        {
+            runs.back().last = column;
+        }
+        else
+        {
+            runs.push_back({row, column, column});
+        }
+    }
+
+    for (auto const &run : runs)
+    {
+        unsigned int x(run.first * dirty_tile_size);
+        unsigned int y(run.row * dirty_tile_size);
+        dirty.push_back({x, y, std::min((run.last + 1) * dirty_tile_size, size) - x,
+                         std::min(y + dirty_tile_size, size) - y});
+    }
+
+    // Pairs (run, index in the frame) of the primitives which touch a run
+    hits.clear();
+    for (size_t i(0); i < frame.size(); i++)
+    {
+        for_each_covered_tiles(
+            frame[i], n_tiles,
+            [&](unsigned int first_column, unsigned int last_column,
+                unsigned int first_row, unsigned int last_row)
+            {
+                for (unsigned int row(first_row); row <= last_row; row++)
+                {
+                    auto run = std::lower_bound(
+                        runs.begin(), runs.end(), DirtyRun{row, first_column, 0},
+                        [](DirtyRun const &a, DirtyRun const &b)
+                        {
+                            return a.row < b.row ||
+                                   (a.row == b.row && a.last < b.first);
+                        });
+                    for (; run != runs.end() && run->row == row &&
+                           run->first <= last_column;
+                         ++run)
+                    {
+                        hits.push_back({unsigned(run - runs.begin()), unsigned(i)});
+                    }
+                }
+            });
+    }
+    std::sort(hits.begin(), hits.end());
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+
+    if (renderer == PIXELS)
+    {
+        auto &raster = get_raster();
+        for (auto const &area : dirty)
+        {
+            raster.set_clip(area);
+            raster.clear();
+        }
+
+        // Same order as below: the runs don't overlap
+        for (auto const &hit : hits)
+        {
+            raster.set_clip(dirty[hit.first]);
+            raster.draw(frame[hit.second]);
+        }
+
+        surface->mark_dirty();
+        return;
+    }
+
+    auto cc = create_default_cc();
+
+    cc->save();
+    cc->set_operator(Cairo::Operator::OPERATOR_CLEAR);
+    for (auto const &area : dirty)
+    {
+        cc->rectangle(area.x, area.y, area.width, area.height);
+    }
+    cc->fill();
+    cc->restore();
+
+    /* Each run is drawn again with the primitives which touch it, in the order of the
+     * frame and clipped to the run: the runs don't overlap, so each cell ends up as if
+     * the whole frame had been drawn */
+    for (size_t begin(0), end(0); begin < hits.size(); begin = end)
+    {
+        run_frame.clear();
+        for (end = begin;
+             end < hits.size() && hits[end].first == hits[begin].first; end++)
+        {
+            run_frame.push_back(frame[hits[end].second]);
+        }
+
+        auto const &area = dirty[hits[begin].first];
+        cc->save();
+        cc->rectangle(area.x, area.y, area.width, area.height);
+        cc->clip();
+        draw_batched(cc, run_frame);
+        cc->restore();
+    }
+
+    surface->flush();
+}
+
 // ====================================================================================
 // Draw functions
 
@@ -126,6 +749,11 @@ void Graphic::clear_surface()
 
 void Graphic::draw_grid_mesh(const string &grid_lines_color, int cell_size)
 {
+    if (scale_factor < min_scale_factor_grid_mesh)
+    {
+        return;
+    }
+
     auto cc = create_default_cc();
 
     set_source_rgba(cc, RGBA(grid_lines_color));
@@ -210,58 +838,24 @@ void Graphic::draw_filled_square(unsigned int x, unsigned int y, unsigned int si
     Graphic::draw_filled_square(x, y, side, get_color(color_index));
 }
 
-/**
- * @brief Creates the diagonal pattern: one square 2x2 |X O||O X| where X has color @p
- * color_index and O a lighter version of @p color_index
- *
- * @param color_index
- * @param parity
- * @return Cairo::RefPtr<Cairo::SurfacePattern>
- */
-Cairo::RefPtr<Cairo::SurfacePattern> create_diagonal_pattern(unsigned int color_index,
-                                                             unsigned int parity)
-{
-    RGBA dark_color(get_color(color_index));
-    RGBA light_color(get_color(color_index, true));
-
-    auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, 2, 2);
-    auto cc = Cairo::Context::create(surface);
-
-    if (parity == 1)
-    {
-        Cairo::Matrix ctm{1, 0, 0, -1, 0, 2};
-        cc->set_matrix(ctm);
-    }
-
-    set_source_rgba(cc, dark_color);
-    cc->rectangle(0, 0, cell_size, cell_size);
-    cc->rectangle(cell_size, cell_size, cell_size, cell_size);
-    cc->fill();
-
-    set_source_rgba(cc, light_color);
-    cc->rectangle(cell_size, 0, cell_size, cell_size);
-    cc->rectangle(0, cell_size, cell_size, cell_size);
-    cc->fill();
-
-    surface->flush();
-
-    auto pattern = Cairo::SurfacePattern::create(surface);
-    pattern->set_filter(Cairo::Filter::FILTER_NEAREST);
-    pattern->set_extend(Cairo::Extend::EXTEND_REPEAT);
-
-    return pattern;
-}
-
 void Graphic::draw_diagonal_pattern_square(unsigned int x, unsigned int y,
                                            unsigned int side, unsigned int color_index)
 {
     auto cc = create_default_cc();
 
-    /* Instead of creating each square independently, we create a square of 2x2, with
-     * the diagonal pattern and use this as filling pattern */
-    auto diagonal_pattern = create_diagonal_pattern(color_index, (x - y) % 2);
+    /* Instead of creating each square independently, we use a square of 2x2 with the
+     * diagonal pattern as filling pattern, it is built once for each color */
+    auto const &palette = get_palette();
+    if (color_index == white)
+    {
+        set_source_rgba(cc, palette.white);
+    }
+    else
+    {
+        cc->set_source(
+            palette.diagonal[color_index % std::size(palette.dark)][(x - y) % 2]);
+    }
 
-    cc->set_source(diagonal_pattern);
     cc->rectangle(x, y, side, side);
     cc->fill();
 
@@ -290,38 +884,3 @@ void Graphic::draw_plus_pattern_square(unsigned int x, unsigned int y,
 
     surface->flush();
 }
-
-// ====================================================================================
-// Undraw functions
-
-void Graphic::undraw_square(unsigned int x, unsigned int y, unsigned int side)
-{
-    auto cc = create_default_cc();
-
-    cc->save();
-    cc->set_source_rgba(0, 0, 0, 0);
-    cc->set_operator(Cairo::Operator::OPERATOR_CLEAR);
-    cc->rectangle(x, y, side, side);
-    cc->fill();
-    cc->restore();
-
-    surface->flush();
-}
-
-void Graphic::undraw_thick_border_square(unsigned int x, unsigned int y,
-                                         unsigned int side)
-{
-    auto cc = create_default_cc();
-    cc->save();
-
-    cc->set_source_rgba(0, 0, 0, 0);
-    cc->set_operator(Cairo::Operator::OPERATOR_CLEAR);
-    cc->set_line_width(thick_border_linewidth);
-
-    cc->rectangle(x + cell_size / 2, y + cell_size / 2, side - cell_size,
-                  side - cell_size);
-    cc->stroke();
-
-    cc->restore();
-    surface->flush();
-}
\ No newline at end of file
@@ -14,12 +14,107 @@
 #ifndef GRAPHICS_H
 #define GRAPHICS_H
 
+#include <climits>
+#include <string>
+#include <vector>
+
 /**
  * @namespace Graphic
  * @brief Provides all the methods needed to draw on the current surface
  */
 namespace Graphic
 {
+    /**
+     * @brief Color index of the elements drawn in white (e.g: foods)
+     */
+    constexpr unsigned int white(UINT_MAX);
+
+    enum Shape
+    {
+        DIAMOND,
+        THICK_BORDER,
+        FILLED,
+        DIAGONAL_PATTERN,
+        PLUS_PATTERN
+    };
+
+    /**
+     * @brief One element to draw: a square with bottom-left corner at (x, y), drawn
+     * with \b shape (see the corresponding draw_*) and \b color_index
+     *
+     */
+    struct Primitive
+    {
+        Shape shape;
+        unsigned int x;
+        unsigned int y;
+        unsigned int side;
+        unsigned int color_index;
+    };
+
+    /**
+     * @brief Snapshot of everything that has to be drawn on the surface, filled by the
+     * model (see Simulation::draw) and drawn at once by \b draw_frame
+     */
+    using Frame = std::vector<Primitive>;
+
+    /**
+     * @brief Rectangle of the surface in cells, with bottom-left corner at (x, y)
+     *
+     */
+    struct Area
+    {
+        unsigned int x;
+        unsigned int y;
+        unsigned int width;
+        unsigned int height;
+    };
+
+    /**
+     * @brief How \b draw_frame and \b draw_frame_changes draw on the surface: with
+     * Cairo, or by writing the pixels of the surface directly (see Raster), which is
+     * much faster for big worlds. Both give the same shapes and colors
+     */
+    enum Renderer
+    {
+        CAIRO,
+        PIXELS
+    };
+
+    /**
+     * @brief Selects the renderer of the frames, Cairo by default
+     *
+     * @param renderer
+     */
+    void set_renderer(Renderer renderer);
+
+    /**
+     * @brief Clears the surface and draws all the primitives of @p frame in order.
+     * With Cairo, a single context is used: the consecutive primitives with the same
+     * shape and color are drawn together, and the colors and patterns are built only
+     * once. Two such primitives with a pattern must not superpose each other, which
+     * the grid guarantees for the ants of the model
+     *
+     * @param frame
+     */
+    void draw_frame(Frame const &frame);
+
+    /**
+     * @brief Turns the surface from @p previous, the frame drawn on it so far, into
+     * @p frame by redrawing only the cells covered by the primitives which appeared,
+     * disappeared or are drawn in another order than before: those cells are cleared
+     * and the primitives of @p frame which touch them are drawn again in order,
+     * clipped to them. When most of the surface has changed, the whole frame is drawn
+     * again instead
+     *
+     * @param previous
+     * @param frame
+     * @param[out] dirty areas of the surface that were redrawn, which have to be
+     * redrawn on the screen as well
+     */
+    void draw_frame_changes(Frame const &previous, Frame const &frame,
+                            std::vector<Area> &dirty);
+
     /**
      * @brief Erases everything from the surface
      */
@@ -127,24 +222,6 @@ namespace Graphic
     void draw_plus_pattern_square(unsigned int x, unsigned int y, unsigned int side,
                                   unsigned int color_index);
 
-    /**
-     * @brief Erases everything in the area of the square (x,y) with length \b side
-     *
-     * @param x
-     * @param y
-     * @param side
-     */
-    void undraw_square(unsigned int x, unsigned int y, unsigned int side);
-
-    /**
-     * @brief Erases the border of the square (x,y) with length \b side
-     *
-     * @param x
-     * @param y
-     * @param side
-     */
-    void undraw_thick_border_square(unsigned int x, unsigned int y, unsigned int side);
-
 } // namespace Graphic
 
 #endif
\ No newline at end of file
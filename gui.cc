@@ -8,7 +8,9 @@
  *
  */
 
-#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <string>
 
 #include <glibmm.h>
 #include <gtkmm-3.0/gtkmm/aspectframe.h>
@@ -20,6 +22,7 @@
 
 #include "graphic-private.h"
 #include "graphic.h"
+#include "squarecell.h"
 
 #include "gui.h"
 
@@ -30,6 +33,9 @@ constexpr unsigned int lg_margin(10);
 
 constexpr unsigned int drawing_area_size(500);
 
+constexpr double max_ticks_per_second(10000);
+constexpr double max_ticks_per_frame(1000);
+
 using std::string;
 
 string format_anthill_info_markup(unsigned int &index, unsigned int &n_collectors,
@@ -37,9 +43,19 @@ string format_anthill_info_markup(unsigned int &index, unsigned int &n_collector
                                   double &n_foods);
 
 MainWindow::MainWindow(Simulation *simulation)
-    : simulation(simulation), exit_button("Exit"), open_button("Open"),
-      save_button("Save"), start_stop_button("Start"), step_button("Step"),
-      next_anthill_button("Next"), prev_anthill_button("Prev")
+    : simulation(simulation),
+      simulation_thread(*simulation,
+                        [this]
+                        {
+                            // Called by the simulation thread
+                            if (!snapshot_notified.exchange(true))
+                            {
+                                snapshot_dispatcher.emit();
+                            }
+                        }),
+      exit_button("Exit"), open_button("Open"), save_button("Save"),
+      start_stop_button("Start"), step_button("Step"), next_anthill_button("Next"),
+      prev_anthill_button("Prev")
 {
     // Layout
     set_title("Main");
@@ -54,6 +70,7 @@ MainWindow::MainWindow(Simulation *simulation)
     build_layout_general_box();
     build_layout_food_box();
     build_layout_anthill_box();
+    build_layout_speed_box();
     build_layout_graphic();
 
     // This frame is invisible and expandable, so the others controlls don't resize
@@ -61,13 +78,13 @@ MainWindow::MainWindow(Simulation *simulation)
     resizable_frame->set_vexpand();
     resizable_frame->set_shadow_type(Gtk::SHADOW_NONE);
     resizable_frame->unset_label();
-    grid.attach(*resizable_frame, 0, 3, 1, 1);
+    grid.attach(*resizable_frame, 0, 4, 1, 1);
 
     add(grid);
     show_all_children();
 
     // We initialize the surface for DrawingImage
-    unsigned int const g_max(128);
+    unsigned int const g_max(Squarecell::get_grid_size());
     unsigned int const cell_size(1);
 
     background_grid_surface = create_surface(g_max);
@@ -78,7 +95,11 @@ MainWindow::MainWindow(Simulation *simulation)
     Graphic::draw_grid_mesh("grey", cell_size);
     model_surface = create_surface(g_max);
 
-    // When closing, we have to stop idle, otherwise it will not stop
+    snapshot_dispatcher.connect(
+        sigc::mem_fun(*this, &MainWindow::on_snapshot_published));
+    publish_simulation();
+
+    // When closing, we have to stop the simulation thread, otherwise it will not stop
     signal_hide().connect(sigc::mem_fun(*this, &MainWindow::on_exit));
 }
 
@@ -98,6 +119,8 @@ void MainWindow::enable_layout()
                                 "</b>");
     anthill_info_label.set_markup("<small><b>No selection</b></small>");
 
+    publish_simulation();
+
     keyboard_shortcuts_complete = signal_key_release_event().connect(
         sigc::mem_fun(*this, &MainWindow::on_key_release_complete));
     keyboard_shortcuts_reduced = signal_key_release_event().connect(
@@ -178,6 +201,43 @@ void MainWindow::build_layout_anthill_box()
     grid.attach(anthill_frame, 0, 2, 1, 1);
 }
 
+void MainWindow::build_layout_speed_box()
+{
+    auto *speed_grid = Gtk::manage(new Gtk::Grid());
+    speed_grid->set_column_spacing(xs_margin);
+    speed_grid->set_row_spacing(xs_margin);
+    speed_grid->set_margin_left(sm_margin);
+    speed_grid->set_margin_right(sm_margin);
+    speed_grid->set_margin_bottom(sm_margin);
+
+    // By default the steps run as fast as possible, and each one is drawn
+    ticks_per_second_button.set_adjustment(
+        Gtk::Adjustment::create(0, 0, max_ticks_per_second, 1, 10));
+    ticks_per_frame_button.set_adjustment(
+        Gtk::Adjustment::create(1, 1, max_ticks_per_frame, 1, 10));
+
+    auto *ticks_per_second_label = Gtk::manage(new Gtk::Label("Ticks/s (0: max)"));
+    auto *ticks_per_frame_label = Gtk::manage(new Gtk::Label("Ticks/frame"));
+    ticks_per_second_label->set_halign(Gtk::ALIGN_START);
+    ticks_per_frame_label->set_halign(Gtk::ALIGN_START);
+
+    speed_grid->attach(*ticks_per_second_label, 0, 0, 1, 1);
+    speed_grid->attach(ticks_per_second_button, 1, 0, 1, 1);
+    speed_grid->attach(*ticks_per_frame_label, 0, 1, 1, 1);
+    speed_grid->attach(ticks_per_frame_button, 1, 1, 1, 1);
+
+    speed_frame.set_label("Speed:");
+    speed_frame.add(*speed_grid);
+
+    grid.attach(speed_frame, 0, 3, 1, 1);
+
+    // Signals Binding
+    ticks_per_second_button.signal_value_changed().connect(
+        sigc::mem_fun(*this, &MainWindow::on_speed_changed));
+    ticks_per_frame_button.signal_value_changed().connect(
+        sigc::mem_fun(*this, &MainWindow::on_speed_changed));
+}
+
 void MainWindow::build_layout_graphic()
 {
     // Layout
@@ -191,7 +251,7 @@ void MainWindow::build_layout_graphic()
     drawing_area.set_size_request(drawing_area_size, drawing_area_size);
     aspect_frame->add(drawing_area);
 
-    grid.attach(*aspect_frame, 1, 0, 1, 4);
+    grid.attach(*aspect_frame, 1, 0, 1, 5);
 
     // Signals Binding
     drawing_area.signal_draw().connect(
@@ -202,7 +262,7 @@ void MainWindow::reset_layout()
 {
     keyboard_shortcuts_complete.disconnect();
     keyboard_shortcuts_reduced.disconnect();
-    idle.disconnect();
+    simulation_thread.pause();
 
     save_button.set_sensitive(false);
     start_stop_button.set_sensitive(false);
@@ -216,10 +276,9 @@ void MainWindow::reset_layout()
     food_count_label.set_markup("<small><b>No simulation</b></small>");
     anthill_info_label.set_markup("<small><b>No simulation</b></small>");
 
-    Graphic::clear_surface();
-    drawing_area.queue_draw();
-
-    iteration = 0;
+    // The frame is rebuilt from the simulation, which has to be emptied
+    simulation->reset();
+    publish_simulation();
 }
 
 // ====================================================================================
@@ -266,15 +325,16 @@ void MainWindow::on_save_button_click()
     {
         string filename = dialog.get_filename();
 
+        simulation_thread.pause();
         simulation->save_file(filename);
     }
 }
 
 void MainWindow::on_start_stop()
 {
-    if (idle.connected())
+    if (simulation_thread.is_running())
     {
-        idle.disconnect();
+        simulation_thread.pause();
 
         anthill_frame.set_sensitive(true);
         open_button.set_sensitive(true);
@@ -300,8 +360,7 @@ void MainWindow::on_start_stop()
         keyboard_shortcuts_complete.block();
         keyboard_shortcuts_reduced.unblock();
 
-        idle = Glib::signal_idle().connect(
-            sigc::mem_fun(*this, &MainWindow::on_iteration), Glib::PRIORITY_LOW);
+        simulation_thread.start();
     }
 }
 
@@ -313,6 +372,8 @@ void MainWindow::on_prev()
     unsigned int n_predators(0);
     double n_foods(0);
 
+    // A step asked just before may still be running
+    simulation_thread.pause();
     if (simulation->get_info_prev_anthill(index, n_collectors, n_defensors,
                                           n_predators, n_foods))
     {
@@ -334,6 +395,8 @@ void MainWindow::on_next()
     unsigned int n_predators(0);
     double n_foods(0);
 
+    // A step asked just before may still be running
+    simulation_thread.pause();
     if (simulation->get_info_next_anthill(index, n_collectors, n_defensors,
                                           n_predators, n_foods))
     {
@@ -350,31 +413,84 @@ void MainWindow::on_next()
 void MainWindow::on_step()
 {
     anthill_info_label.set_markup("<small><b>No selection</b></small>");
-    on_iteration();
+    simulation_thread.step();
 }
 
 void MainWindow::on_exit()
 {
-    idle.disconnect();
+    simulation_thread.pause();
 
     std::exit(0);
 }
 
-bool MainWindow::on_iteration()
+void MainWindow::on_speed_changed()
 {
-    if (!simulation->step())
+    simulation_thread.set_ticks_per_second(ticks_per_second_button.get_value());
+    simulation_thread.set_ticks_per_frame(ticks_per_frame_button.get_value_as_int());
+}
+
+void MainWindow::on_snapshot_published()
+{
+    // Cleared first, so that a snapshot published from now on wakes up the GUI again
+    snapshot_notified = false;
+    queue_model_update();
+}
+
+void MainWindow::publish_simulation()
+{
+    simulation_thread.reset_ticks();
+    simulation_thread.publish();
+}
+
+void MainWindow::queue_model_update()
+{
+    if (!model_update_pending)
     {
+        model_update_pending = true;
+        drawing_area.add_tick_callback(
+            sigc::mem_fun(*this, &MainWindow::on_model_update));
     }
+}
 
-    iteration++;
-    std::cout << "Iteration: " << iteration << "\n";
+bool MainWindow::on_model_update(const Glib::RefPtr<Gdk::FrameClock> &)
+{
+    model_update_pending = false;
 
-    food_count_label.set_markup("<b>" + std::to_string(simulation->get_n_foods()) +
-                                "</b>");
+    // Only the latest snapshot is drawn, the ones published since the last frame
+    if (!simulation_thread.update_snapshot())
+    {
+        return false;
+    }
 
-    drawing_area.queue_draw();
+    auto const &snapshot = simulation_thread.get_snapshot();
+    Graphic::draw_frame_changes(drawn_frame, snapshot.frame, dirty_areas);
+    drawn_frame = snapshot.frame;
 
-    return true;
+    // Without a simulation, the label tells it instead
+    if (food_frame.get_sensitive())
+    {
+        food_count_label.set_markup("<b>" + std::to_string(snapshot.n_foods) +
+                                    "</b>");
+    }
+
+    /* The areas are in cells with the y-axis upwards, they are rounded outwards to
+     * pixels of the drawing area, whose y-axis is downwards */
+    auto allocation = drawing_area.get_allocation();
+    const double width = allocation.get_width();
+    const double height = allocation.get_height();
+    const double size = Squarecell::get_grid_size();
+
+    for (auto const &area : dirty_areas)
+    {
+        int left(std::floor(area.x * width / size));
+        int right(std::ceil((area.x + area.width) * width / size));
+        int top(std::floor(height - (area.y + area.height) * height / size));
+        int bottom(std::ceil(height - area.y * height / size));
+
+        drawing_area.queue_draw_area(left, top, right - left, bottom - top);
+    }
+
+    return false;
 }
 
 bool MainWindow::on_key_release_reduced(GdkEventKey *event)
@@ -398,9 +514,7 @@ bool MainWindow::on_key_release_complete(GdkEventKey *event)
 
     if (event->type == GDK_KEY_RELEASE && event->keyval == GDK_KEY_1)
     {
-        on_iteration();
-        anthill_info_label.set_markup("<small><b>No selection</b></small>");
-
+        on_step();
         return true;
     }
 
@@ -435,6 +549,7 @@ bool MainWindow::on_draw_request(const Cairo::RefPtr<Cairo::Context> &cc)
         cc->paint();
     }
 
+    // model_surface is kept up to date by on_model_update
     if (model_surface)
     {
         cc->set_source(model_surface, 0, 0);
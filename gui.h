@@ -11,14 +11,21 @@
 #ifndef GUI_H
 #define GUI_H
 
+#include <atomic>
+#include <vector>
+
+#include <glibmm/dispatcher.h>
 #include <gtkmm-3.0/gtkmm/button.h>
 #include <gtkmm-3.0/gtkmm/drawingarea.h>
 #include <gtkmm-3.0/gtkmm/frame.h>
 #include <gtkmm-3.0/gtkmm/grid.h>
 #include <gtkmm-3.0/gtkmm/label.h>
+#include <gtkmm-3.0/gtkmm/spinbutton.h>
 #include <gtkmm-3.0/gtkmm/window.h>
 
+#include "graphic.h"
 #include "simulation.h"
+#include "simulation_thread.h"
 
 class MainWindow : public Gtk::Window
 {
@@ -46,6 +53,7 @@ private:
     void build_layout_general_box();
     void build_layout_food_box();
     void build_layout_anthill_box();
+    void build_layout_speed_box();
     void build_layout_graphic();
     void reset_layout();
 
@@ -57,8 +65,36 @@ private:
     void on_next();
     void on_step();
     void on_exit();
+    void on_speed_changed();
+
+    /**
+     * @brief Signal handler for snapshot_dispatcher, in the GUI thread: a new snapshot
+     * of the simulation was published
+     *
+     */
+    void on_snapshot_published();
+
+    /**
+     * @brief Publishes the state of the simulation after it was modified by the GUI
+     * (read, reset), while the simulation thread is paused
+     *
+     */
+    void publish_simulation();
+
+    /**
+     * @brief Asks for \b on_model_update before the next frame of the window, the
+     * snapshots published in the meantime are skipped
+     *
+     */
+    void queue_model_update();
 
-    bool on_iteration();
+    /**
+     * @brief Brings model_surface up to date with the latest snapshot of the
+     * simulation and invalidates only the parts of the drawing area that changed
+     *
+     * @return false, the callback is removed once called
+     */
+    bool on_model_update(const Glib::RefPtr<Gdk::FrameClock> &clock);
 
     /**
      * @brief Signal handler for the keyboard shortcuts:
@@ -99,6 +135,27 @@ private:
      */
     Cairo::RefPtr<Cairo::ImageSurface> model_surface;
 
+    /**
+     * @brief Frame currently drawn on model_surface: only the areas which differ
+     * between it and the latest snapshot are redrawn (see Graphic::draw_frame_changes)
+     */
+    Graphic::Frame drawn_frame;
+    std::vector<Graphic::Area> dirty_areas;
+    bool model_update_pending = false;
+
+    /**
+     * @brief Wakes up the GUI thread when the simulation thread publishes a snapshot,
+     * at most once until the GUI handles it (snapshot_notified)
+     */
+    Glib::Dispatcher snapshot_dispatcher;
+    std::atomic<bool> snapshot_notified{false};
+
+    /**
+     * @brief Runs the steps of the simulation, which the GUI only uses while it is
+     * paused (reading, saving, anthill reports)
+     */
+    SimulationThread simulation_thread;
+
     /**
      * keyboard_shortcuts_reduced and complete are needed for connecting/disconnecting
      * the signal handlers when needed, i.e: while empty disconnecting both, while
@@ -107,16 +164,15 @@ private:
     sigc::connection keyboard_shortcuts_reduced;
     sigc::connection keyboard_shortcuts_complete;
 
-    sigc::connection idle;
-
     Gtk::Grid grid;
-    Gtk::Frame general_button_frame, food_frame, anthill_frame;
+    Gtk::Frame general_button_frame, food_frame, anthill_frame, speed_frame;
     Gtk::DrawingArea drawing_area;
     Gtk::Button exit_button, open_button, save_button, start_stop_button, step_button,
         next_anthill_button, prev_anthill_button;
     Gtk::Label food_count_label, anthill_info_label;
 
-    unsigned int iteration = 0;
+    // Target steps per second (0 for as fast as possible) and steps per snapshot
+    Gtk::SpinButton ticks_per_second_button, ticks_per_frame_button;
 };
 
 #endif
\ No newline at end of file
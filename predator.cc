@@ -8,115 +8,114 @@
  *
  */
 
-#include <cmath>
-#include <memory>
-#include <sstream>
 #include <stdexcept>
+#include <string_view>
+#include <vector>
 
+#include "config.h"
 #include "message.h"
 #include "squarecell.h"
 
 #include "predator.h"
 
-using std::istringstream;
 using std::string;
-using std::unique_ptr;
+using std::string_view;
 using std::vector;
 
+using Squarecell::Square;
+
+Squarecell::Engine Predator::engine(Squarecell::LEE);
+
 // ====================================================================================
 // Initialization - Misc
 
-Predator::Predator(unsigned int x, unsigned int y, unsigned int age,
-                   unsigned int color_index)
-    : Ant{x, y, sizeP, age, color_index}
+void Predator::insert(AntColumns &predators, unsigned int x, unsigned int y,
+                      unsigned int age)
 {
-    Squarecell::test_square(*this);
-    add_to_grid();
-}
+    Square predator{x, y, sizeP, true};
 
-Predator::~Predator()
-{
-    remove_from_grid();
-    undraw();
+    Squarecell::test_square(predator);
+    add_to_grid(predator);
+
+    predators.push_back(x, y, age, EMPTY);
 }
 
-void Predator::add_to_grid()
+void Predator::add_to_grid(Square const &predator)
 {
-    if (Squarecell::test_if_superposed_grid(*this))
+    if (Squarecell::test_if_superposed_grid(predator))
     {
-        throw std::invalid_argument(message::predator_overlap(x, y));
+        throw std::invalid_argument(message::predator_overlap(predator.x, predator.y));
     }
 
-    Squarecell::add_square(*this);
+    Squarecell::add_square(predator);
 }
 
-void Predator::remove_from_grid() { Squarecell::remove_square(*this); }
-
-void Predator::draw() { Squarecell::draw_filled(*this, get_color_index()); }
+void Predator::draw(Graphic::Frame &frame, AntColumns const &predators,
+                    unsigned int color_index)
+{
+    for (size_t i(0); i < predators.size(); i++)
+    {
+        if (predators.alive[i])
+        {
+            Squarecell::draw_filled(frame, predators.get_square(i), color_index);
+        }
+    }
+}
 
-void Predator::undraw() { Squarecell::undraw_square(*this); }
+void Predator::set_engine(Squarecell::Engine engine) { Predator::engine = engine; }
 
 // ====================================================================================
 // Simulation
 
-bool Predator::step() { return increase_age(); }
-
-void Predator::remain_inside(Squarecell::Square &anthill_square)
+void Predator::remain_inside(AntColumns &predators, size_t i, Square &anthill_square,
+                             Square const *planned)
 {
-    remove_from_grid();
-    undraw();
+    auto predator = predators.get_square(i);
+    Squarecell::remove_square(predator);
 
-    auto move =
-        Squarecell::lee_algorithm(*this, anthill_square, &Predator::generate_moves,
-                                  &Squarecell::test_if_completely_confined);
+    auto move = planned && !Squarecell::test_if_superposed_grid(*planned)
+                    ? *planned
+                    : search_inside(predator, anthill_square);
 
-    x = move.x;
-    y = move.y;
+    predator.x = move.x;
+    predator.y = move.y;
 
-    add_to_grid();
-    draw();
+    predators.set_position(i, predator);
+    add_to_grid(predator);
 }
 
-void Predator::move_toward_nearest_ant(vector<Squarecell::Square> &ants)
+void Predator::move_toward_nearest_ant(AntColumns &predators, size_t i,
+                                       vector<Square> &ants, Square const *planned)
 {
-    auto target = find_target_ant(ants);
+    auto predator = predators.get_square(i);
+    Squarecell::remove_square(predator);
 
-    remove_from_grid();
-    undraw();
+    auto move = planned && !Squarecell::test_if_superposed_grid(*planned)
+                    ? *planned
+                    : search_nearest_ant(predator, ants);
 
-    Squarecell::remove_square(target);
+    predator.x = move.x;
+    predator.y = move.y;
 
-    auto move = Squarecell::lee_algorithm(*this, target, &Predator::generate_moves,
-                                          &Predator::test_if_reached_ant);
-
-    x = move.x;
-    y = move.y;
-
-    if (!test_if_reached_ant(*this, target))
-    {
-        Squarecell::add_square(target);
-    }
-
-    add_to_grid();
-    draw();
+    predators.set_position(i, predator);
+    add_to_grid(predator);
 }
 
-Squarecell::Square Predator::find_target_ant(vector<Squarecell::Square> &ants)
+Squarecell::Square Predator::search_inside(Square const &origin, Square const &anthill)
 {
-    auto target = ants.front();
-
-    unsigned int best_distance = std::pow(x - target.x, 2) + std::pow(y - target.y, 2);
-    for (auto &ant : ants)
-    {
-        unsigned int distance = std::pow(x - ant.x, 2) + std::pow(y - ant.y, 2);
-        if (distance < best_distance)
-        {
-            target = ant;
-            best_distance = distance;
-        }
-    }
+    return Squarecell::find_path<Moves>(
+        origin, anthill, [](Square const &origin, Square const &anthill)
+        { return Squarecell::test_if_completely_confined(origin, anthill); },
+        engine);
+}
 
-    return target;
+Squarecell::Square Predator::search_nearest_ant(Square const &origin,
+                                                vector<Square> const &ants)
+{
+    return Squarecell::find_path<Moves>(
+        origin, ants, [](Square const &origin, Square const &ant)
+        { return test_if_reached_ant(origin, ant); },
+        engine);
 }
 
 bool Predator::filter_ants(State_anthill state, Squarecell::Square &anthill,
@@ -130,13 +129,9 @@ bool Predator::filter_ants(State_anthill state, Squarecell::Square &anthill,
     return Squarecell::test_if_completely_confined(ant, anthill);
 }
 
-vector<Squarecell::Square> Predator::generate_moves(Square origin)
+void Predator::generate_moves(Square const &origin, vector<Square> &moves)
 {
-    // All the possible shifts combinations:
-    vector<int> x_shift{1, 1, -1, -1, 3, 3, -3, -3};
-    vector<int> y_shift{3, -3, 3, -3, 1, -1, 1, -1};
-
-    return Ant::generate_moves(origin, x_shift, y_shift);
+    Ant::generate_moves(origin, Moves::x_shift, Moves::y_shift, Moves::n, moves);
 }
 
 bool Predator::test_if_reached_ant(Squarecell::Square const &origin,
@@ -146,16 +141,16 @@ bool Predator::test_if_reached_ant(Squarecell::Square const &origin,
            Squarecell::test_if_superposed_two_square(origin, ant);
 }
 
-unique_ptr<Predator> Predator::parse_line(string &line, unsigned int color_index)
+void Predator::parse_line(string_view line, AntColumns &predators)
 {
     unsigned int x(0);
     unsigned int y(0);
     unsigned int age(0);
 
-    istringstream stream(line);
+    Config::Line stream(line);
     stream >> x;
     stream >> y;
     stream >> age;
 
-    return unique_ptr<Predator>(new Predator(x, y, age, color_index));
+    insert(predators, x, y, age);
 }
@@ -11,46 +11,86 @@
 #ifndef ANTS_PREDATOR_H
 #define ANTS_PREDATOR_H
 
-#include <memory>
+#include <algorithm>
+#include <string_view>
+#include <vector>
 
 #include "ants.h"
 #include "constantes.h"
 #include "squarecell.h"
 
-class Predator : public Ant
+/**
+ * @brief Behaviour of the predators, which are the entries @p i of the AntColumns
+ * @p predators of their anthill
+ *
+ */
+class Predator
 {
 public:
+    static constexpr unsigned int side = sizeP;
+
     /**
-     * @brief Constructs a new Predator instance
+     * @brief Appends a new predator to @p predators and adds it to the grid
      *
+     * @param predators
      * @param x position of predator in the x-axis
      * @param y position of predator in the y-axis
      * @param age
-     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) same as
-     * graphic.h
      */
-    Predator(unsigned int x, unsigned int y, unsigned int age,
-             unsigned int color_index);
-    ~Predator() override;
+    static void insert(AntColumns &predators, unsigned int x, unsigned int y,
+                       unsigned int age);
 
-    void add_to_grid() override;
-    void remove_from_grid() override;
-
-    void draw() override;
-    void undraw() override;
+    /**
+     * @brief Checks that position in the grid is empty and either throw an error or
+     * fills the grid
+     *
+     * @param predator
+     */
+    static void add_to_grid(Squarecell::Square const &predator);
 
     /**
-     * @brief It increases the age and return true if the predator died of old age
+     * @brief Appends the predators alive of @p predators to @p frame
      *
-     * @return true if dead
      */
-    bool step();
+    static void draw(Graphic::Frame &frame, AntColumns const &predators,
+                     unsigned int color_index);
 
-    void remain_inside(Squarecell::Square &anthill_square);
+    /**
+     * @brief Moves the predator to the nearest position completely inside \b anthill
+     *
+     * @param predators
+     * @param i
+     * @param anthill_square
+     * @param planned next position searched in advance (see Anthill::plan_moves),
+     * used instead of a new search if it is still free
+     */
+    static void remain_inside(AntColumns &predators, size_t i,
+                              Squarecell::Square &anthill_square,
+                              Squarecell::Square const *planned = nullptr);
 
-    void move_toward_nearest_ant(std::vector<Squarecell::Square> &ants);
+    /**
+     * @brief Moves the predator toward the nearest (in number of moves) of @p ants
+     * that it can reach
+     *
+     * @param predators
+     * @param i
+     * @param ants
+     * @param planned same as \b remain_inside
+     */
+    static void move_toward_nearest_ant(AntColumns &predators, size_t i,
+                                        std::vector<Squarecell::Square> &ants,
+                                        Squarecell::Square const *planned = nullptr);
 
-    Squarecell::Square find_target_ant(std::vector<Squarecell::Square> &ants);
+    /**
+     * @brief Returns the first move of \b remain_inside (\b move_toward_nearest_ant)
+     * from @p origin, which must not be in the grid. They only read the grid
+     *
+     */
+    static Squarecell::Square search_inside(Squarecell::Square const &origin,
+                                            Squarecell::Square const &anthill);
+    static Squarecell::Square
+    search_nearest_ant(Squarecell::Square const &origin,
+                       std::vector<Squarecell::Square> const &ants);
 
     /**
      * @brief Given the position of the ant and the state of the Anthill, it determines
@@ -65,24 +105,52 @@ public:
                             Squarecell::Square &ant);
 
     /**
-     * @brief Generates all the possible new positions / moves based on the origin
+     * @brief Moves policy for Squarecell::lee_algorithm: jumps of (1, 3) and (3, 1)
+     * in every direction. Each jump closes at most 3 cells in one axis and 4 cells
+     * in total
+     *
+     */
+    struct Moves
+    {
+        static constexpr size_t n = 8;
+        static constexpr int x_shift[n]{1, 1, -1, -1, 3, 3, -3, -3};
+        static constexpr int y_shift[n]{3, -3, 3, -3, 1, -1, 1, -1};
+
+        static constexpr unsigned int heuristic(unsigned int dx, unsigned int dy)
+        {
+            return std::max({(dx + 2) / 3, (dy + 2) / 3, (dx + dy + 3) / 4});
+        }
+    };
+
+    /**
+     * @brief Selects the search engine used by all the predators (LEE by default)
+     *
+     * @param engine
+     */
+    static void set_engine(Squarecell::Engine engine);
+
+
+    /**
+     * @brief Appends all the possible new positions / moves based on the origin
      *
      * @param origin
-     * @return std::vector<Square>
+     * @param[out] moves
      */
-    static std::vector<Squarecell::Square> generate_moves(Squarecell::Square origin);
+    static void generate_moves(Squarecell::Square const &origin,
+                               std::vector<Squarecell::Square> &moves);
 
     static bool test_if_reached_ant(Squarecell::Square const &origin,
                                     Squarecell::Square const &ant);
     /**
-     * @brief Creates a new pointed instance of Predator from its string representation
+     * @brief Appends to @p predators the predator of its string representation
      *
      * @param line
-     * @param color_index
-     * @return std::unique_ptr<Predator>
+     * @param predators
      */
-    static std::unique_ptr<Predator> parse_line(std::string &line,
-                                                unsigned int color_index);
+    static void parse_line(std::string_view line, AntColumns &predators);
+
+private:
+    static Squarecell::Engine engine;
 };
 
 #endif
\ No newline at end of file
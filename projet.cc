@@ -8,27 +8,99 @@
  *
  */
 
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
 #include <gtkmm-3.0/gtkmm/application.h>
 
+#include "defensor.h"
+#include "generator.h"
+#include "graphic.h"
 #include "gui.h"
+#include "predator.h"
 #include "simulation.h"
+#include "squarecell.h"
 
 using std::string;
 
-int main(int argc, char *argv[])
+struct Arguments
 {
-    auto app = Gtk::Application::create("org.com112.project");
+    // The configuration file, empty if none was given
+    string path;
 
-    Simulation simulation;
-    MainWindow main(&simulation);
+    // Batch mode: number of steps to run without GUI and where to save the result
+    bool batch = false;
+    unsigned long ticks = 0;
+    string out_path;
+
+    /* Batch mode: the file is a binary snapshot, and a snapshot is saved every
+     * checkpoint ticks (and at the end) */
+    bool resume = false;
+    unsigned long checkpoint = 0;
+    string checkpoint_path;
+
+    // Threads of the two-phase step, 0 for the sequential one
+    unsigned int threads = 0;
+
+    // Threads of the searches of the ants in the sequential step, 0 for none
+    unsigned int search_threads = 0;
+
+    // Seed of the random numbers of the simulation, a snapshot resumed keeps its own
+    unsigned long long seed = 0;
+    bool seed_given = false;
+};
+
+/**
+ * @brief Parses the command line: projet [--size N] [--astar TYPES] [--threads N]
+ * [--search-threads N] [--seed N] [--renderer NAME] [--ticks N [--out FILE]
+ * [--resume] [--checkpoint N FILE]] [file], where TYPES is a comma-separated list of
+ * ant types (generator, defensor, predator) that use the A* search instead of the Lee
+ * algorithm, --threads selects the two-phase step on N threads (see
+ * Simulation::set_threads), --search-threads the searches of the ants on N threads
+ * (see Simulation::set_search_threads), --seed the seed of the random numbers (see
+ * Simulation::set_seed) and --renderer how the world is drawn (cairo or pixels, see
+ * Graphic::set_renderer). With --resume, the file is a snapshot to go on from (with
+ * its own seed, a different --seed is an error), and --checkpoint saves a snapshot in
+ * FILE every N steps (see Simulation::save_snapshot)
+ *
+ * @param argc
+ * @param argv
+ * @param[out] arguments
+ * @return false if the arguments are not valid
+ */
+bool parse_arguments(int argc, char *argv[], Arguments &arguments);
+
+/**
+ * @brief Enables the A* search for each ant type of the comma-separated list @p types
+ *
+ * @param types
+ * @return false if an ant type is unknown
+ */
+bool parse_engines(string const &types);
+
+/**
+ * @brief Runs the simulation of @p arguments for the given number of steps (or until
+ * all the anthills are dead) without initializing GTK, then saves the final state
+ * and reports the number of steps per second
+ *
+ * @param arguments
+ * @return the exit code
+ */
+int run_batch(Arguments &arguments);
 
-    if (argc == 2)
+int main(int argc, char *argv[])
+{
+    Arguments arguments;
+    if (!parse_arguments(argc, argv, arguments))
     {
-        string path(argv[1]);
-        if (simulation.read_file(path))
-        {
-            main.enable_layout();
-        }
+        return 1;
+    }
+
+    if (arguments.batch)
+    {
+        return run_batch(arguments);
     }
 
 /** When the preprocessor directive HEADLESS is present, the program will be compiled
@@ -38,11 +110,264 @@ int main(int argc, char *argv[])
  */
 #ifndef HEADLESS
 
+    auto app = Gtk::Application::create("org.com112.project");
+
+    Simulation simulation;
+    simulation.set_threads(arguments.threads);
+    simulation.set_search_threads(arguments.search_threads);
+    simulation.set_seed(arguments.seed);
+    MainWindow main(&simulation);
+
+    if (!arguments.path.empty())
+    {
+        if (simulation.read_file(arguments.path))
+        {
+            main.enable_layout();
+        }
+    }
+
     return app->run(main);
 
 #else
 
+    Simulation simulation;
+    simulation.set_threads(arguments.threads);
+    simulation.set_search_threads(arguments.search_threads);
+    simulation.set_seed(arguments.seed);
+
+    if (!arguments.path.empty())
+    {
+        simulation.read_file(arguments.path);
+    }
+
     return 0;
 
 #endif
-}
\ No newline at end of file
+}
+
+int run_batch(Arguments &arguments)
+{
+    if (arguments.path.empty())
+    {
+        std::cout << "--ticks requires a configuration file" << std::endl;
+        return 1;
+    }
+
+    Simulation simulation;
+    simulation.set_threads(arguments.threads);
+    simulation.set_search_threads(arguments.search_threads);
+    simulation.set_seed(arguments.seed);
+    if (!(arguments.resume ? simulation.load_snapshot(arguments.path)
+                           : simulation.read_file(arguments.path)))
+    {
+        return 1;
+    }
+
+    if (arguments.resume && arguments.seed_given &&
+        simulation.get_seed() != arguments.seed)
+    {
+        std::cout << "the snapshot was saved with the seed " << simulation.get_seed()
+                  << ", not " << arguments.seed << std::endl;
+        return 1;
+    }
+
+    unsigned long ticks(0);
+    bool checkpoint_saved(false);
+    auto start = std::chrono::steady_clock::now();
+    while (ticks < arguments.ticks)
+    {
+        ticks++;
+        if (!simulation.step())
+        {
+            checkpoint_saved = false;
+            break;
+        }
+
+        checkpoint_saved =
+            arguments.checkpoint != 0 && ticks % arguments.checkpoint == 0;
+        if (checkpoint_saved && !simulation.save_snapshot(arguments.checkpoint_path))
+        {
+            std::cout << "cannot write " << arguments.checkpoint_path << std::endl;
+            return 1;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "ticks: " << ticks << ", time: " << seconds
+              << " s, ticks/s: " << (seconds > 0 ? ticks / seconds : 0) << std::endl;
+
+    if (!arguments.out_path.empty())
+    {
+        simulation.save_file(arguments.out_path);
+    }
+
+    // The final state is already saved if the last step was a checkpoint
+    if (arguments.checkpoint != 0 && !checkpoint_saved &&
+        !simulation.save_snapshot(arguments.checkpoint_path))
+    {
+        std::cout << "cannot write " << arguments.checkpoint_path << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+bool parse_arguments(int argc, char *argv[], Arguments &arguments)
+{
+    for (int i(1); i < argc; i++)
+    {
+        string argument(argv[i]);
+
+        if (argument == "--size" && i + 1 < argc)
+        {
+            try
+            {
+                // The world size has to be set before any surface / element is created
+                Squarecell::set_grid_size(std::stoul(argv[++i]));
+            }
+            catch (std::exception &e)
+            {
+                std::cout << "invalid world size: " << e.what() << std::endl;
+                return false;
+            }
+        }
+        else if (argument == "--ticks" && i + 1 < argc)
+        {
+            try
+            {
+                arguments.ticks = std::stoul(argv[++i]);
+                arguments.batch = true;
+            }
+            catch (std::exception &e)
+            {
+                std::cout << "invalid number of ticks: " << e.what() << std::endl;
+                return false;
+            }
+        }
+        else if (argument == "--threads" && i + 1 < argc)
+        {
+            try
+            {
+                arguments.threads = std::stoul(argv[++i]);
+            }
+            catch (std::exception &e)
+            {
+                std::cout << "invalid number of threads: " << e.what() << std::endl;
+                return false;
+            }
+        }
+        else if (argument == "--search-threads" && i + 1 < argc)
+        {
+            try
+            {
+                arguments.search_threads = std::stoul(argv[++i]);
+            }
+            catch (std::exception &e)
+            {
+                std::cout << "invalid number of threads: " << e.what() << std::endl;
+                return false;
+            }
+        }
+        else if (argument == "--seed" && i + 1 < argc)
+        {
+            try
+            {
+                arguments.seed = std::stoull(argv[++i]);
+                arguments.seed_given = true;
+            }
+            catch (std::exception &e)
+            {
+                std::cout << "invalid seed: " << e.what() << std::endl;
+                return false;
+            }
+        }
+        else if (argument == "--renderer" && i + 1 < argc)
+        {
+            string name(argv[++i]);
+            if (name == "cairo")
+            {
+                Graphic::set_renderer(Graphic::CAIRO);
+            }
+            else if (name == "pixels")
+            {
+                Graphic::set_renderer(Graphic::PIXELS);
+            }
+            else
+            {
+                std::cout << "unknown renderer: " << name << std::endl;
+                return false;
+            }
+        }
+        else if (argument == "--resume")
+        {
+            arguments.resume = true;
+        }
+        else if (argument == "--checkpoint" && i + 2 < argc)
+        {
+            try
+            {
+                arguments.checkpoint = std::stoul(argv[++i]);
+                arguments.checkpoint_path = argv[++i];
+            }
+            catch (std::exception &e)
+            {
+                std::cout << "invalid checkpoint interval: " << e.what() << std::endl;
+                return false;
+            }
+        }
+        else if (argument == "--out" && i + 1 < argc)
+        {
+            arguments.out_path = argv[++i];
+        }
+        else if (argument == "--astar" && i + 1 < argc)
+        {
+            if (!parse_engines(argv[++i]))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            arguments.path = argument;
+        }
+    }
+
+    return true;
+}
+
+bool parse_engines(string const &types)
+{
+    size_t start(0);
+    while (start <= types.size())
+    {
+        size_t end = types.find(',', start);
+        if (end == string::npos)
+        {
+            end = types.size();
+        }
+
+        string type = types.substr(start, end - start);
+        if (type == "generator")
+        {
+            Generator::set_engine(Squarecell::ASTAR);
+        }
+        else if (type == "defensor")
+        {
+            Defensor::set_engine(Squarecell::ASTAR);
+        }
+        else if (type == "predator")
+        {
+            Predator::set_engine(Squarecell::ASTAR);
+        }
+        else
+        {
+            std::cout << "unknown ant type for --astar: " << type << std::endl;
+            return false;
+        }
+
+        start = end + 1;
+    }
+
+    return true;
+}
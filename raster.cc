@@ -0,0 +1,308 @@
+/**
+ * @file raster.cc
+ * @author Daniel Panero 100%, Andrea Diez 0%
+ * @version 0.1
+ * @date 2022-05-31
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "graphic.h"
+#include "raster.h"
+
+// ====================================================================================
+// Rows of pixels
+
+/**
+ * @brief Sets the @p n pixels from @p row to @p color, 4 at a time with SSE2
+ *
+ */
+static void fill_row(uint32_t *row, size_t n, uint32_t color)
+{
+    size_t i(0);
+#ifdef __SSE2__
+    __m128i value = _mm_set1_epi32(color);
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), value);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i + 4), value);
+    }
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), value);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        row[i] = color;
+    }
+}
+
+/**
+ * @brief Copies the @p n pixels of @p source to @p row, 4 at a time with SSE2
+ *
+ */
+static void copy_row(uint32_t *row, uint32_t const *source, size_t n)
+{
+    size_t i(0);
+#ifdef __SSE2__
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<__m128i const *>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), value);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        row[i] = source[i];
+    }
+}
+
+/**
+ * @brief First pixel whose center is at or after @p coordinate (in pixels): the
+ * pixels drawn by a shape [a, b) are [first_pixel(a), first_pixel(b))
+ *
+ */
+static int first_pixel(double coordinate) { return std::ceil(coordinate - 0.5); }
+
+// ====================================================================================
+// Raster
+
+Raster::Raster(unsigned int scale, double border_width, Colors const &colors)
+    : scale(scale), border_width(border_width), colors(colors)
+{
+    // Diamond of a cell, computed as in draw_diamond
+    double half(scale / 2.0);
+    for (unsigned int row(0); row < scale; row++)
+    {
+        double radius = half - std::abs(row + 0.5 - half);
+        diamond_tile.begin.push_back(first_pixel(half - radius));
+        diamond_tile.end.push_back(first_pixel(half + radius));
+    }
+}
+
+unsigned int Raster::get_scale() const { return scale; }
+
+void Raster::set_target(uint32_t *pixels, unsigned int stride, unsigned int width,
+                        unsigned int height)
+{
+    this->pixels = pixels;
+    this->stride = stride;
+    this->width = width;
+    this->height = height;
+
+    clip_x0 = 0;
+    clip_y0 = 0;
+    clip_x1 = width;
+    clip_y1 = height;
+}
+
+void Raster::set_clip(Graphic::Area const &area)
+{
+    clip_x0 = std::min<int>(area.x * scale, width);
+    clip_x1 = std::min<int>((area.x + area.width) * scale, width);
+    clip_y0 = std::max<int>(height - int((area.y + area.height) * scale), 0);
+    clip_y1 = std::max<int>(height - int(area.y * scale), 0);
+}
+
+void Raster::clear()
+{
+    for (int y(clip_y0); y < clip_y1; y++)
+    {
+        fill_row(pixels + size_t(y) * stride + clip_x0, std::max(clip_x1 - clip_x0, 0),
+                 0);
+    }
+}
+
+void Raster::fill_pixels(double x0, double y0, double x1, double y1, uint32_t color)
+{
+    int first_x = std::max(first_pixel(x0), clip_x0);
+    int last_x = std::min(first_pixel(x1), clip_x1);
+    int first_y = std::max(first_pixel(y0), clip_y0);
+    int last_y = std::min(first_pixel(y1), clip_y1);
+    if (first_x >= last_x)
+    {
+        return;
+    }
+
+    for (int y(first_y); y < last_y; y++)
+    {
+        fill_row(pixels + size_t(y) * stride + first_x, last_x - first_x, color);
+    }
+}
+
+void Raster::fill_rectangle(double x, double y, double width, double height,
+                            uint32_t color)
+{
+    fill_pixels(x * scale, this->height - (y + height) * scale, (x + width) * scale,
+                this->height - y * scale, color);
+}
+
+void Raster::draw(Graphic::Primitive const &primitive)
+{
+    unsigned int x(primitive.x);
+    unsigned int y(primitive.y);
+    unsigned int side(primitive.side);
+    if (side == 0)
+    {
+        return;
+    }
+
+    bool white(primitive.color_index == Graphic::white);
+    unsigned int color(white ? 0 : primitive.color_index % std::size(colors.dark));
+    uint32_t dark(white ? colors.white : colors.dark[color]);
+    uint32_t light(white ? colors.white : colors.light[color]);
+
+    switch (primitive.shape)
+    {
+    case Graphic::DIAMOND:
+        if (side == 1)
+        {
+            draw_tile(diamond_tile, x, y, dark);
+        }
+        else
+        {
+            draw_diamond(x, y, side, dark);
+        }
+        break;
+
+    case Graphic::THICK_BORDER:
+        draw_border(x, y, side, dark);
+        break;
+
+    case Graphic::FILLED:
+        fill_rectangle(x, y, side, side, dark);
+        break;
+
+    case Graphic::DIAGONAL_PATTERN:
+        draw_diagonal(x, y, side, dark, light);
+        break;
+
+    case Graphic::PLUS_PATTERN:
+    {
+        fill_rectangle(x, y, side, side, light);
+
+        double center = (side - 1) / 2.0;
+        fill_rectangle(x + center, y, 1, side, dark);
+        fill_rectangle(x, y + center, side, 1, dark);
+        break;
+    }
+    }
+}
+
+void Raster::draw_tile(Tile const &tile, unsigned int x, unsigned int y,
+                       uint32_t color)
+{
+    int left(x * scale);
+    int top(height - int((y + 1) * scale));
+    for (unsigned int row(0); row < scale; row++)
+    {
+        int pixel_y(top + int(row));
+        if (pixel_y < clip_y0 || pixel_y >= clip_y1)
+        {
+            continue;
+        }
+
+        int first_x = std::max(left + tile.begin[row], clip_x0);
+        int last_x = std::min(left + tile.end[row], clip_x1);
+        if (first_x < last_x)
+        {
+            fill_row(pixels + size_t(pixel_y) * stride + first_x, last_x - first_x,
+                     color);
+        }
+    }
+}
+
+void Raster::draw_diamond(unsigned int x, unsigned int y, unsigned int side,
+                          uint32_t color)
+{
+    double half(side * scale / 2.0);
+    double center_x(x * scale + half);
+    double center_y(height - (y * scale + half));
+
+    int first_y = std::max(int(std::floor(center_y - half)), clip_y0);
+    int last_y = std::min(int(std::ceil(center_y + half)), clip_y1);
+    for (int pixel_y(first_y); pixel_y < last_y; pixel_y++)
+    {
+        double radius = half - std::abs(pixel_y + 0.5 - center_y);
+        if (radius <= 0)
+        {
+            continue;
+        }
+
+        // The row of the diamond is [center_x - radius, center_x + radius)
+        int first_x = std::max(first_pixel(center_x - radius), clip_x0);
+        int last_x = std::min(first_pixel(center_x + radius), clip_x1);
+        if (first_x < last_x)
+        {
+            fill_row(pixels + size_t(pixel_y) * stride + first_x, last_x - first_x,
+                     color);
+        }
+    }
+}
+
+void Raster::draw_border(unsigned int x, unsigned int y, unsigned int side,
+                         uint32_t color)
+{
+    /* The line goes through the centers of the cells of the border: it is the union of
+     * its 4 sides, each one extended by half the width for the miter joins */
+    double w(border_width / 2);
+    double left((x + 0.5) * scale);
+    double right((x + side - 0.5) * scale);
+    double bottom(height - (y + 0.5) * scale);
+    double top(height - (y + side - 0.5) * scale);
+
+    fill_pixels(left - w, top - w, right + w, top + w, color);
+    fill_pixels(left - w, bottom - w, right + w, bottom + w, color);
+    fill_pixels(left - w, top - w, left + w, bottom + w, color);
+    fill_pixels(right - w, top - w, right + w, bottom + w, color);
+}
+
+void Raster::draw_diagonal(unsigned int x, unsigned int y, unsigned int side,
+                           uint32_t dark, uint32_t light)
+{
+    int left(x * scale);
+    int first_x = std::max(left, clip_x0);
+    int last_x = std::min(left + int(side * scale), clip_x1);
+    if (first_x >= last_x)
+    {
+        return;
+    }
+
+    /* The bottom-left cell is dark and the colors alternate: each row of cells is
+     * built once in pattern_row, then copied to its rows of pixels */
+    pattern_row.resize(side * scale);
+    for (unsigned int j(0); j < side; j++)
+    {
+        int top(height - int((y + j + 1) * scale));
+        int first_y = std::max(top, clip_y0);
+        int last_y = std::min(top + int(scale), clip_y1);
+        if (first_y >= last_y)
+        {
+            continue;
+        }
+
+        for (unsigned int i(0); i < side; i++)
+        {
+            uint32_t color((i + j) % 2 == 0 ? dark : light);
+            fill_row(pattern_row.data() + i * scale, scale, color);
+        }
+        for (int pixel_y(first_y); pixel_y < last_y; pixel_y++)
+        {
+            copy_row(pixels + size_t(pixel_y) * stride + first_x,
+                     pattern_row.data() + (first_x - left), last_x - first_x);
+        }
+    }
+}
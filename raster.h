@@ -0,0 +1,138 @@
+/**
+ * @file raster.h
+ * @author Daniel Panero, Andrea Diez
+ * @brief Rasterizer of the frames straight into the pixels of an ARGB32 image, used by
+ * Graphic instead of Cairo with the PIXELS renderer (see Graphic::set_renderer)
+ * @version 0.1
+ * @date 2022-05-31
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "graphic.h"
+
+/**
+ * @brief Draws the primitives of a frame on an image with the same geometry as the
+ * Cairo path of Graphic (a cell is scale x scale pixels, the y-axis goes up, no
+ * antialiasing: a pixel is drawn when its center is inside the shape), but by writing
+ * the pixels directly: the rows of the squares are filled with SIMD stores and the
+ * diamond of the foods is a tile computed once for the scale
+ *
+ */
+class Raster
+{
+public:
+    /**
+     * @brief Premultiplied ARGB32 colors of the color indexes
+     *
+     */
+    struct Colors
+    {
+        uint32_t white;
+        uint32_t dark[6];
+        uint32_t light[6];
+    };
+
+    /**
+     * @param scale number of pixels of the side of a cell
+     * @param border_width width in pixels of the line of the borders
+     * @param colors
+     */
+    Raster(unsigned int scale, double border_width, Colors const &colors);
+
+    unsigned int get_scale() const;
+
+    /**
+     * @brief Sets the image to draw on, and draws on all of it
+     *
+     * @param pixels first pixel of the top row
+     * @param stride number of pixels between the starts of two rows
+     * @param width
+     * @param height
+     */
+    void set_target(uint32_t *pixels, unsigned int stride, unsigned int width,
+                    unsigned int height);
+
+    /**
+     * @brief Draws only inside @p area until the next \b set_clip / \b set_target
+     *
+     * @param area in cells
+     */
+    void set_clip(Graphic::Area const &area);
+
+    /**
+     * @brief Makes the pixels of the clip area transparent
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Draws @p primitive over the image, clipped to the clip area
+     *
+     * @param primitive
+     */
+    void draw(Graphic::Primitive const &primitive);
+
+private:
+    /**
+     * @brief Pixels [begin, end) of each row of a cell covered by a shape
+     *
+     */
+    struct Tile
+    {
+        std::vector<int> begin;
+        std::vector<int> end;
+    };
+
+    /**
+     * @brief Fills the pixels whose center is inside [x0, x1) x [y0, y1), in pixels
+     * from the top-left corner of the image
+     *
+     */
+    void fill_pixels(double x0, double y0, double x1, double y1, uint32_t color);
+
+    /**
+     * @brief Fills the rectangle with bottom-left corner at (x, y), in cells
+     *
+     */
+    void fill_rectangle(double x, double y, double width, double height,
+                        uint32_t color);
+
+    void draw_tile(Tile const &tile, unsigned int x, unsigned int y, uint32_t color);
+    void draw_diamond(unsigned int x, unsigned int y, unsigned int side,
+                      uint32_t color);
+    void draw_border(unsigned int x, unsigned int y, unsigned int side,
+                     uint32_t color);
+    void draw_diagonal(unsigned int x, unsigned int y, unsigned int side,
+                       uint32_t dark, uint32_t light);
+
+    unsigned int scale;
+    double border_width;
+    Colors colors;
+
+    // Diamond of a single cell (the foods)
+    Tile diamond_tile;
+
+    uint32_t *pixels = nullptr;
+    unsigned int stride = 0;
+    int width = 0;
+    int height = 0;
+
+    // Clip area in pixels [clip_x0, clip_x1) x [clip_y0, clip_y1)
+    int clip_x0 = 0;
+    int clip_y0 = 0;
+    int clip_x1 = 0;
+    int clip_y1 = 0;
+
+    // One row of a diagonal pattern, kept between the draws
+    std::vector<uint32_t> pattern_row;
+};
+
+#endif
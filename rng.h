@@ -0,0 +1,59 @@
+/**
+ * @file rng.h
+ * @author Daniel Panero, Andrea Diez
+ * @brief Seedable random number generator with independent streams
+ * @version 0.1
+ * @date 2022-05-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+/**
+ * @brief Counter-based SplitMix64 generator: the n-th number of a stream is a hash of
+ * (key, n), where the key is derived from a seed and a stream number. The streams of
+ * the same seed are independent, so that each part of the simulation can draw its
+ * numbers in any order without changing the numbers of the others. It can be used with
+ * the distributions of <random>
+ *
+ */
+class Rng
+{
+public:
+    using result_type = uint64_t;
+
+    Rng() : Rng(0) {}
+
+    explicit Rng(uint64_t seed, uint64_t stream = 0)
+        : key(mix(seed ^ mix(stream + gamma)))
+    {
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()() { return mix(key + ++counter * gamma); }
+
+private:
+    // Finalizer of SplitMix64 (variant 13 of the MurmurHash3 mixer)
+    static constexpr uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr uint64_t gamma = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t key;
+
+    // Number of numbers drawn so far
+    uint64_t counter = 0;
+};
+
+#endif
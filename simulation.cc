@@ -9,35 +9,31 @@
  */
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <random>
-#include <sstream>
 #include <stdexcept>
 #include <vector>
 
 #include "anthill.h"
-#include "collector.h"
-#include "defensor.h"
+#include "config.h"
 #include "food.h"
 #include "message.h"
-#include "predator.h"
+#include "snapshot.h"
 
 #include "simulation.h"
 
 using std::endl;
-using std::ifstream;
-using std::istringstream;
 using std::string;
 using std::vector;
 
-unsigned int const g_max(128);
-
 bool Simulation::read_file(string &path)
 {
     reset();
 
-    ifstream file(path);
+    Config::File file(path);
     try
     {
         if (file.fail())
@@ -51,7 +47,6 @@ bool Simulation::read_file(string &path)
         check_overlapping_anthills();
         check_generator_defensors_inside_anthills();
 
-        file.close();
         std::cout << message::success();
 
         return true;
@@ -61,8 +56,6 @@ bool Simulation::read_file(string &path)
         std::cout << e.what() << endl;
     }
 
-    file.close();
-
     reset();
     return false;
 }
@@ -90,26 +83,143 @@ void Simulation::save_file(string &path)
     file.close();
 }
 
-bool Simulation::step()
+// Magic number and version of the snapshots
+static constexpr char snapshot_magic[8] = {'A', 'N', 'T', 'S', 'N', 'A', 'P', '\0'};
+static constexpr uint32_t snapshot_version(1);
+
+bool Simulation::save_snapshot(string const &path)
 {
-    index_anthill = 0;
-    first_execution = true;
+    SnapshotHeader header{};
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.grid_size = Squarecell::get_grid_size();
+    header.seed = seed;
+    header.random_num = random_num;
+    header.n_anthills = anthills.size();
+
+    string out;
+    Snapshot::write(out, header);
+
+    Squarecell::Grid grid;
+    Squarecell::copy_grid(grid);
+    Snapshot::write_array(out, grid);
+
+    vector<FoodRecord> records;
+    records.reserve(foods.size());
+    for (auto const &food : foods)
+    {
+        auto square = food->get_as_square();
+        records.push_back({square.x, square.y});
+    }
+    Snapshot::write_array(out, records);
+
+    for (auto const &anthill : anthills)
+    {
+        anthill->write_snapshot(out);
+    }
 
-    Squarecell::surface_clear();
+    std::ofstream file(path, std::ios::binary);
+    file.write(out.data(), out.size());
 
-    for (const auto &food : foods)
+    return !file.fail();
+}
+
+bool Simulation::load_snapshot(string const &path)
+{
+    reset();
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (file.fail())
+    {
+        return false;
+    }
+
+    // The whole snapshot is read at once, the records are then copied from it
+    string in(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(&in[0], in.size());
+    if (file.fail())
+    {
+        return false;
+    }
+
+    char const *data = in.data();
+    char const *end = data + in.size();
+    try
+    {
+        SnapshotHeader header{};
+        Snapshot::read(data, end, header);
+        if (std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0 ||
+            header.version != snapshot_version)
+        {
+            throw std::invalid_argument("not a snapshot (version " +
+                                        std::to_string(snapshot_version) + ")");
+        }
+        if (header.grid_size != Squarecell::get_grid_size())
+        {
+            throw std::invalid_argument("snapshot of a world of size " +
+                                        std::to_string(header.grid_size));
+        }
+
+        Squarecell::Grid grid;
+        Snapshot::read_array(data, end, grid);
+
+        vector<FoodRecord> records;
+        Snapshot::read_array(data, end, records);
+        for (auto const &record : records)
+        {
+            foods.insert(std::unique_ptr<Food>(new Food(record.x, record.y)));
+        }
+
+        for (uint64_t i(0); i < header.n_anthills; i++)
+        {
+            anthills.push_back(Anthill::read_snapshot(data, end));
+        }
+
+        if (data != end)
+        {
+            throw std::invalid_argument("unexpected data at the end of the snapshot");
+        }
+
+        /* The elements have added themselves to the grid when they were created, but
+         * the grid can also hold cells of no element (the food of a loaded collector
+         * killed, see Anthill::clear_dead_ants), which the next steps see too */
+        Squarecell::restore_grid(grid);
+
+        seed = header.seed;
+        random_num = header.random_num;
+
+        return true;
+    }
+    catch (std::invalid_argument &e)
     {
-        food->draw();
+        std::cout << e.what() << endl;
     }
 
+    reset();
+    return false;
+}
+
+bool Simulation::step()
+{
+    index_anthill = 0;
+    first_execution = true;
+
     generate_foods();
 
-    for (auto &anthill : anthills)
+    if (pool)
     {
-        if (!anthill->step(foods, anthills))
+        step_anthills_in_two_phases();
+    }
+    else
+    {
+        for (auto &anthill : anthills)
         {
-            dead_anthills.push_back(std::move(anthill));
-        };
+            if (!anthill->step(foods, anthills, search_pool.get()))
+            {
+                dead_anthills.push_back(std::move(anthill));
+            };
+        }
     }
 
     anthills.erase(std::remove(anthills.begin(), anthills.end(), nullptr),
@@ -130,6 +240,61 @@ bool Simulation::step()
     return true;
 }
 
+void Simulation::set_threads(unsigned int n_threads)
+{
+    pool.reset(n_threads == 0 ? nullptr : new ThreadPool(n_threads));
+}
+
+void Simulation::set_search_threads(unsigned int n_threads)
+{
+    search_pool.reset(n_threads == 0 ? nullptr : new ThreadPool(n_threads));
+}
+
+void Simulation::set_seed(uint64_t seed) { this->seed = seed; }
+uint64_t Simulation::get_seed() const { return seed; }
+
+void Simulation::step_anthills_in_two_phases()
+{
+    // The expansion only depends on the squares of the anthills, it stays sequential
+    for (auto &anthill : anthills)
+    {
+        anthill->try_to_expand(anthills);
+    }
+
+    planned_alive.assign(anthills.size(), 0);
+    pool->run(anthills.size(), [this](size_t i)
+              { planned_alive[i] = anthills[i]->plan(foods, anthills); });
+
+    for (auto &anthill : anthills)
+    {
+        anthill->commit_kills();
+    }
+
+    for (size_t i(0); i < anthills.size(); i++)
+    {
+        anthills[i]->commit(foods, planned_alive[i]);
+        if (!planned_alive[i])
+        {
+            dead_anthills.push_back(std::move(anthills[i]));
+        }
+    }
+}
+
+void Simulation::draw(Graphic::Frame &frame)
+{
+    frame.clear();
+
+    for (auto const &food : foods)
+    {
+        food->draw(frame);
+    }
+
+    for (auto const &anthill : anthills)
+    {
+        anthill->draw(frame);
+    }
+}
+
 void Simulation::reset()
 {
     index_anthill = 0;
@@ -140,7 +305,9 @@ void Simulation::reset()
     dead_anthills.clear();
     foods.clear();
 
-    // We reset the squarecell grid and clear the model_surface
+    random_num = Rng(seed, 0);
+
+    // We reset the squarecell grid
     Squarecell::grid_clear();
 }
 
@@ -196,32 +363,25 @@ bool Simulation::cycle_info_anthill(unsigned int &index, unsigned int &n_collect
     return true;
 }
 
-void Simulation::parse_foods(ifstream &file)
+void Simulation::parse_foods(Config::File &file)
 {
-    string line(get_next_line(file));
-    istringstream stream(line);
+    Config::Line stream(file.next_line());
 
     unsigned int n_foods(0);
     stream >> n_foods;
 
-    foods.resize(n_foods);
-
     unsigned int i(0);
     while (i < n_foods)
     {
-        line = get_next_line(file);
-
-        foods[i] = Food::parse_line(line);
-        foods[i]->draw();
+        foods.insert(Food::parse_line(file.next_line()));
 
         i++;
     }
 }
 
-void Simulation::parse_anthills(ifstream &file)
+void Simulation::parse_anthills(Config::File &file)
 {
-    string line(get_next_line(file));
-    istringstream stream(line);
+    Config::Line stream(file.next_line());
 
     unsigned int n_anthills(0);
     stream >> n_anthills;
@@ -231,47 +391,13 @@ void Simulation::parse_anthills(ifstream &file)
     unsigned int i(0);
     while (i < n_anthills)
     {
-        line = get_next_line(file);
-        anthills[i] = Anthill::parse_line(line, i);
-
-        auto collectors =
-            parse_ants<Collector>(file, anthills[i]->get_number_of_collectors(), i);
-        auto defensors =
-            parse_ants<Defensor>(file, anthills[i]->get_number_of_defensors(), i);
-        auto predators =
-            parse_ants<Predator>(file, anthills[i]->get_number_of_predators(), i);
-
-        anthills[i]->set_collectors(collectors);
-        anthills[i]->set_defensors(defensors);
-        anthills[i]->set_predators(predators);
-
-        anthills[i]->draw();
+        anthills[i] = Anthill::parse(file, i);
+        anthills[i]->seed_random(seed, i + 1);
 
         i++;
     }
 }
 
-template <typename T>
-vector<std::unique_ptr<T>> Simulation::parse_ants(ifstream &file, unsigned int n,
-                                                  unsigned int index_anthill)
-{
-    string line;
-    vector<std::unique_ptr<T>> ants(n);
-
-    unsigned int j(0);
-    while (j < n)
-    {
-        line = get_next_line(file);
-
-        ants[j] = T::parse_line(line, index_anthill);
-        ants[j]->draw();
-
-        j++;
-    }
-
-    return ants;
-}
-
 void Simulation::check_overlapping_anthills()
 {
     for (size_t i = 0; i < anthills.size(); i++)
@@ -300,9 +426,10 @@ void Simulation::check_generator_defensors_inside_anthills()
 void Simulation::generate_foods()
 {
 
+    unsigned int g_max = Squarecell::get_grid_size();
+
     std::uniform_int_distribution<unsigned> generate_coordinate(1, g_max - 2);
     std::bernoulli_distribution b_distribution(food_rate);
-    static std::default_random_engine random_num;
 
     unsigned int x = 0;
     unsigned int y = 0;
@@ -335,21 +462,6 @@ void Simulation::generate_foods()
     if (found && b_distribution(random_num))
     {
         std::unique_ptr<Food> food(new Food(x, y));
-        food->draw();
-        foods.push_back(std::move(food));
-    }
-}
-
-string get_next_line(ifstream &file)
-{
-    string line;
-    while (getline(file >> std::ws, line))
-    {
-        if (line[0] == '#')
-        {
-            continue;
-        }
-        return line;
+        foods.insert(std::move(food));
     }
-    return "";
 }
@@ -11,18 +11,23 @@
 #ifndef SIMULATION_H
 #define SIMULATION_H
 
+#include <cstdint>
 #include <memory>
 
 #include "anthill.h"
+#include "config.h"
 #include "food.h"
+#include "graphic.h"
+#include "rng.h"
+#include "threadpool.h"
 
 class Simulation
 {
 public:
     /**
-     * @brief Reads the file, prepares the simulation model and draws all the elements
-     * on the model_surface. In the case of an error in the configuration file, it
-     * safely discards all the elements of model and clears it self
+     * @brief Reads the file and prepares the simulation model. In the case of an error
+     * in the configuration file, it safely discards all the elements of model and
+     * clears it self
      *
      * @param path
      * @return true if there are no errors in the configuration file, false in the case
@@ -31,6 +36,29 @@ public:
     bool read_file(std::string &path);
     void save_file(std::string &path);
 
+    /**
+     * @brief Saves the whole state of the simulation between two steps in a binary
+     * file: unlike \b save_file, it keeps the random numbers, the exact food of the
+     * anthills, the order of the elements and the grid, so that a simulation loaded
+     * with \b load_snapshot goes on exactly as this one. The file is made of
+     * fixed-size records in the byte order of the machine (see snapshot.h)
+     *
+     * @param path
+     * @return false if the file can't be written
+     */
+    bool save_snapshot(std::string const &path);
+
+    /**
+     * @brief Loads a file written by \b save_snapshot for the same world size. The
+     * seed of the snapshot replaces the one of \b set_seed, so that the simulation
+     * goes on with the same random numbers. In the case of an error, it prints it and
+     * clears the simulation, same as \b read_file
+     *
+     * @param path
+     * @return false if the snapshot is not valid
+     */
+    bool load_snapshot(std::string const &path);
+
     /**
      * @brief This function advances each aspect of the simulation (Anthills, Foods..)
      * by one step
@@ -39,10 +67,56 @@ public:
      */
     bool step();
 
+    /**
+     * @brief Selects how \b step advances the anthills. With 0 (the default), they
+     * step one after the other and each of them sees what the previous ones have done.
+     * Otherwise, a step has two phases: first all the anthills plan their step at the
+     * same time (on @p n_threads threads) from the world as it was at the beginning of
+     * the step, then the plans are committed one anthill after the other, in the order
+     * of the anthills, which resolves the conflicts: an ant can't move to a position
+     * taken by an ant committed before, a food taken twice goes to the first
+     * collector committed and all the kills are applied before the moves. The result
+     * doesn't depend on @p n_threads (see Anthill::plan)
+     *
+     * @param n_threads
+     */
+    void set_threads(unsigned int n_threads);
+
+    /**
+     * @brief With @p n_threads > 0, the anthills still step one after the other,
+     * but the ants of each kind search their next positions on @p n_threads threads
+     * before moving (see Anthill::step). The result doesn't depend on @p n_threads,
+     * but isn't the same as with 0 (the default), where each ant searches from the
+     * positions of the ants that have moved before it. Not used by the two-phase step
+     *
+     * @param n_threads
+     */
+    void set_search_threads(unsigned int n_threads);
+
+    /**
+     * @brief Selects the seed of the random numbers (0 by default), used from the next
+     * \b reset / \b read_file. The foods and each anthill draw from their own stream
+     * of @p seed, so that the numbers drawn don't depend on the order in which they
+     * step, and a run started again from the same file draws the same numbers
+     *
+     * @param seed
+     */
+    void set_seed(uint64_t seed);
+    uint64_t get_seed() const;
+
+    /**
+     * @brief Fills @p frame with all the elements of the simulation (foods, anthills
+     * and their ants). The simulation itself never draws, so that stepping without GUI
+     * doesn't do any rendering work
+     *
+     * @param[out] frame
+     */
+    void draw(Graphic::Frame &frame);
+
     /**
      * @brief Resets and deallocates every aspect / object of the simulation: foods,
      * anthills, collectors... Furthermore, it resets also the grid of the module
-     * Squarecell and clears the model_surface of Graphic
+     * Squarecell
      *
      */
     void reset();
@@ -102,27 +176,21 @@ public:
                             double &n_food, bool order);
 
 private:
-    void parse_foods(std::ifstream &file);
-    void parse_anthills(std::ifstream &file);
-
-    /**
-     * @brief This is a convenience function for parsing either Ant::Collector,
-     * Ant::Defensor and Ant::Predator
-     *
-     * @tparam T Ant::Collector / Ant::Defensor / Ant::Predator
-     * @param file
-     * @param n number of ants
-     * @return vector<unique_ptr<T>>
-     */
-    template <typename T>
-    std::vector<std::unique_ptr<T>> parse_ants(std::ifstream &file, unsigned int n,
-                                               unsigned int index_anthill);
+    void parse_foods(Config::File &file);
+    void parse_anthills(Config::File &file);
 
     void check_overlapping_anthills();
     void check_generator_defensors_inside_anthills();
 
     void generate_foods();
 
+    /**
+     * @brief Steps the anthills in two phases (see \b set_threads), the dead anthills
+     * are moved to \b dead_anthills
+     *
+     */
+    void step_anthills_in_two_phases();
+
     unsigned int n_anthills = 0;
 
     /**
@@ -142,15 +210,38 @@ private:
     std::vector<std::unique_ptr<Anthill>> anthills;
     std::vector<std::unique_ptr<Anthill>> dead_anthills;
 
-    std::vector<std::unique_ptr<Food>> foods;
-};
+    FoodSet foods;
 
-/**
- * @brief Gets the next non-empty line
- *
- * @param file
- * @return string
- */
-std::string get_next_line(std::ifstream &file);
+    // Stream 0 of seed is the one of the foods, stream i + 1 the one of anthill i
+    uint64_t seed = 0;
+    Rng random_num;
+
+    /**
+     * @brief First record of a snapshot (see \b save_snapshot), followed by the grid,
+     * the foods and the anthills
+     *
+     */
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t grid_size;
+        uint64_t seed;
+        Rng random_num;
+        uint64_t n_anthills;
+    };
+
+    struct FoodRecord
+    {
+        uint32_t x, y;
+    };
+
+    // Only used by the two-phase step
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<uint8_t> planned_alive;
+
+    // Only used by the sequential step
+    std::unique_ptr<ThreadPool> search_pool;
+};
 
 #endif
\ No newline at end of file
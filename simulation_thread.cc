@@ -0,0 +1,218 @@
+/**
+ * @file simulation_thread.cc
+ * @author Daniel Panero 100%, Andrea Diez 0%
+ * @version 0.1
+ * @date 2022-06-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "allocation.h"
+#include "simulation.h"
+
+#include "simulation_thread.h"
+
+SimulationThread::SimulationThread(Simulation &simulation,
+                                   std::function<void()> on_publish)
+    : simulation(simulation), on_publish(std::move(on_publish))
+{
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+SimulationThread::~SimulationThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    changed.notify_all();
+
+    thread.join();
+}
+
+// ====================================================================================
+// Controls
+
+void SimulationThread::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = true;
+    }
+    changed.notify_all();
+}
+
+void SimulationThread::pause()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    running = false;
+    changed.notify_all();
+    changed.wait(lock, [this] { return !busy && pending_steps == 0; });
+    lock.unlock();
+
+    // The thread is idle: the steps it didn't publish are published from here
+    if (unpublished_ticks > 0)
+    {
+        publish();
+    }
+}
+
+void SimulationThread::step()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running)
+        {
+            return;
+        }
+        pending_steps++;
+    }
+    changed.notify_all();
+}
+
+bool SimulationThread::is_running() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return running;
+}
+
+void SimulationThread::set_ticks_per_second(double ticks_per_second)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->ticks_per_second = std::max(ticks_per_second, 0.0);
+        rate_changed = true;
+    }
+    changed.notify_all();
+}
+
+void SimulationThread::set_ticks_per_frame(unsigned int ticks_per_frame)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->ticks_per_frame = std::max(ticks_per_frame, 1u);
+}
+
+void SimulationThread::reset_ticks()
+{
+    ticks = 0;
+    allocations = 0;
+    unpublished_ticks = 0;
+}
+
+// ====================================================================================
+// Snapshots
+
+void SimulationThread::publish()
+{
+    auto &snapshot = snapshots.get_write_buffer();
+    simulation.draw(snapshot.frame);
+    snapshot.n_foods = simulation.get_n_foods();
+    snapshot.ticks = ticks;
+    snapshot.allocations = allocations;
+    snapshots.publish();
+
+    unpublished_ticks = 0;
+    if (on_publish)
+    {
+        on_publish();
+    }
+}
+
+bool SimulationThread::update_snapshot() { return snapshots.update(); }
+
+FrameSnapshot const &SimulationThread::get_snapshot() const
+{
+    return snapshots.get_read_buffer();
+}
+
+// ====================================================================================
+// Thread
+
+void SimulationThread::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        changed.wait(lock, [this] { return stop || running || pending_steps > 0; });
+        if (stop)
+        {
+            return;
+        }
+
+        // A single step is always published, the running ones every ticks_per_frame
+        unsigned int frame_ticks(1);
+        if (running)
+        {
+            if (!wait_next_tick(lock))
+            {
+                continue;
+            }
+            frame_ticks = ticks_per_frame;
+        }
+        else
+        {
+            pending_steps--;
+        }
+
+        busy = true;
+        lock.unlock();
+
+        do_step();
+        if (unpublished_ticks >= frame_ticks)
+        {
+            publish();
+        }
+
+        lock.lock();
+        busy = false;
+        changed.notify_all();
+    }
+}
+
+bool SimulationThread::wait_next_tick(std::unique_lock<std::mutex> &lock)
+{
+    if (ticks_per_second <= 0)
+    {
+        return true;
+    }
+
+    auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1 / ticks_per_second));
+    auto now = Clock::now();
+
+    /* After a pause, a slow step or a new rate, the steps go on from now without
+     * trying to catch up */
+    if (rate_changed || next_tick < now - period)
+    {
+        rate_changed = false;
+        next_tick = now;
+    }
+
+    if (changed.wait_until(lock, next_tick,
+                           [this] { return stop || !running || rate_changed; }))
+    {
+        return false;
+    }
+
+    next_tick += period;
+    return true;
+}
+
+void SimulationThread::do_step()
+{
+    auto start_allocations = Allocation::get_count();
+
+    simulation.step();
+
+    ticks++;
+    allocations += Allocation::get_count() - start_allocations;
+    unpublished_ticks++;
+}
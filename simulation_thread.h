@@ -0,0 +1,175 @@
+/**
+ * @file simulation_thread.h
+ * @author Daniel Panero, Andrea Diez
+ * @brief Thread running the steps of a simulation, which publishes snapshots of it to
+ * draw without waiting for the drawing
+ * @version 0.1
+ * @date 2022-06-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "graphic.h"
+#include "simulation.h"
+#include "triplebuffer.h"
+
+/**
+ * @brief State of the simulation after a step, taken by the thread that draws it
+ *
+ */
+struct FrameSnapshot
+{
+    Graphic::Frame frame;
+    unsigned int n_foods = 0;
+
+    // Number of steps done since the simulation was read / reset
+    unsigned long ticks = 0;
+
+    /* Heap allocations done by the program while these steps ran (see Allocation),
+     * the ones of the other threads at the same time included */
+    unsigned long long allocations = 0;
+};
+
+/**
+ * @brief Runs the steps of a simulation on its own thread, at a target rate or as fast
+ * as possible, and publishes a FrameSnapshot every few steps through a TripleBuffer:
+ * the reader (the GUI) only draws the latest snapshot, a slow step never blocks it and
+ * the steps never wait for the drawing. While the thread is running, the simulation
+ * must not be used by another thread: \b pause gives it back
+ *
+ */
+class SimulationThread
+{
+public:
+    /**
+     * @param simulation
+     * @param on_publish called by the thread after each snapshot it publishes (e.g: to
+     * wake up the reader), it must be thread-safe
+     */
+    SimulationThread(Simulation &simulation, std::function<void()> on_publish);
+    ~SimulationThread();
+
+    SimulationThread(SimulationThread const &) = delete;
+    SimulationThread &operator=(SimulationThread const &) = delete;
+
+    /**
+     * @brief Starts running the steps continuously
+     *
+     */
+    void start();
+
+    /**
+     * @brief Stops running the steps and waits for the current one: once it returns,
+     * the simulation can be used by the caller until the next \b start / \b step. The
+     * snapshot of the last step is published
+     *
+     */
+    void pause();
+
+    /**
+     * @brief Runs a single step on the thread (while paused) and publishes it
+     *
+     */
+    void step();
+
+    bool is_running() const;
+
+    /**
+     * @brief Sets the target rate of the steps
+     *
+     * @param ticks_per_second 0 to run the steps as fast as possible
+     */
+    void set_ticks_per_second(double ticks_per_second);
+
+    /**
+     * @brief Sets the number of steps between two snapshots while running: with more
+     * than 1, the steps in between are never drawn (fast-forward)
+     *
+     * @param ticks_per_frame at least 1
+     */
+    void set_ticks_per_frame(unsigned int ticks_per_frame);
+
+    /**
+     * @brief Counts the steps (and their allocations) from 0 again, after the
+     * simulation was read or reset (while paused)
+     *
+     */
+    void reset_ticks();
+
+    /**
+     * @brief Publishes a snapshot of the current state of the simulation (while
+     * paused), e.g: after reading a file
+     *
+     */
+    void publish();
+
+    /**
+     * @brief Takes the latest snapshot (reader only)
+     *
+     * @return true if there is a new one since the last call
+     */
+    bool update_snapshot();
+
+    /**
+     * @brief Snapshot taken by \b update_snapshot (reader only), it doesn't change
+     * until the next call
+     *
+     */
+    FrameSnapshot const &get_snapshot() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Loop of the thread: waits to be started or asked for a step, then runs
+     * the steps
+     *
+     */
+    void run();
+
+    /**
+     * @brief Waits for the time of the next step when there's a target rate
+     *
+     * @return false if the thread was paused / stopped or the rate changed in the
+     * meantime, the state has to be checked again
+     */
+    bool wait_next_tick(std::unique_lock<std::mutex> &lock);
+
+    void do_step();
+
+    Simulation &simulation;
+    std::function<void()> on_publish;
+    TripleBuffer<FrameSnapshot> snapshots;
+
+    // Only used by the thread which owns the simulation (see pause)
+    unsigned long ticks = 0;
+    unsigned long long allocations = 0;
+    unsigned int unpublished_ticks = 0;
+    Clock::time_point next_tick;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+
+    // Protected by the mutex
+    bool running = false;
+    bool busy = false;
+    bool stop = false;
+    unsigned int pending_steps = 0;
+    double ticks_per_second = 0;
+    bool rate_changed = false;
+    unsigned int ticks_per_frame = 1;
+
+    std::thread thread;
+};
+
+#endif
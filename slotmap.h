@@ -0,0 +1,241 @@
+/**
+ * @file slotmap.h
+ * @author Daniel Panero, Andrea Diez
+ * @brief Container whose elements are referred to by stable handles
+ * @version 0.1
+ * @date 2022-05-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Reference to an element of a SlotMap: the index of its slot and the
+ * generation of the slot when the element was inserted
+ *
+ */
+struct SlotHandle
+{
+    static constexpr uint32_t invalid = UINT32_MAX;
+
+    uint32_t index = invalid;
+    uint32_t generation = 0;
+
+    bool operator==(SlotHandle const &other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(SlotHandle const &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Container of elements referred to by a SlotHandle, which stays valid until
+ * the element is erased. Inserting and erasing are O(1) and never move the other
+ * elements (no compaction pass), the iteration follows the order of insertion. A slot
+ * freed by an erasure is reused with a new generation, so that the handle of an erased
+ * element never refers to another one
+ *
+ * @tparam T
+ */
+template <typename T> class SlotMap
+{
+public:
+    using Handle = SlotHandle;
+
+    template <typename Map, typename Value> class Iterator
+    {
+    public:
+        Iterator(Map *map, uint32_t index) : map(map), index(index) {}
+
+        Value &operator*() const { return map->slots[index].value; }
+        Value *operator->() const { return &map->slots[index].value; }
+
+        /**
+         * @brief The element pointed can be erased before incrementing the iterator,
+         * as long as nothing is inserted in the meantime
+         *
+         */
+        Iterator &operator++()
+        {
+            index = map->slots[index].next;
+            return *this;
+        }
+
+        bool operator==(Iterator const &other) const { return index == other.index; }
+        bool operator!=(Iterator const &other) const { return index != other.index; }
+
+        Handle handle() const { return {index, map->slots[index].generation}; }
+
+    private:
+        Map *map;
+        uint32_t index;
+    };
+
+    using iterator = Iterator<SlotMap, T>;
+    using const_iterator = Iterator<SlotMap const, T const>;
+
+    /**
+     * @brief Appends @p value after all the other elements
+     *
+     * @param value
+     * @return Handle
+     */
+    Handle insert(T value);
+
+    /**
+     * @brief Removes the element of @p handle, which must be valid
+     *
+     * @param handle
+     * @return T the element removed
+     */
+    T erase(Handle handle);
+
+    /**
+     * @brief Returns the element of @p handle or nullptr if it has been erased
+     *
+     */
+    T *get(Handle handle);
+    T const *get(Handle handle) const;
+
+    bool contains(Handle handle) const;
+
+    /**
+     * @brief Erases all the elements, all the handles become invalid
+     *
+     */
+    void clear();
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    iterator begin() { return {this, head}; }
+    iterator end() { return {this, Handle::invalid}; }
+    const_iterator begin() const { return {this, head}; }
+    const_iterator end() const { return {this, Handle::invalid}; }
+
+private:
+    struct Slot
+    {
+        T value;
+        uint32_t generation = 0;
+        bool occupied = false;
+
+        // Neighbours in the order of iteration
+        uint32_t previous = Handle::invalid;
+        uint32_t next = Handle::invalid;
+
+        // Next slot of the free list, separate from next so that an iterator on an
+        // erased element can still be incremented
+        uint32_t next_free = Handle::invalid;
+    };
+
+    std::vector<Slot> slots;
+
+    uint32_t head = Handle::invalid;
+    uint32_t tail = Handle::invalid;
+    uint32_t free_slots = Handle::invalid;
+    size_t count = 0;
+};
+
+// ====================================================================================
+// Templates implementation
+
+template <typename T> SlotHandle SlotMap<T>::insert(T value)
+{
+    uint32_t index = free_slots;
+    if (index == Handle::invalid)
+    {
+        index = slots.size();
+        slots.emplace_back();
+    }
+    else
+    {
+        free_slots = slots[index].next_free;
+    }
+
+    auto &slot = slots[index];
+    slot.value = std::move(value);
+    slot.occupied = true;
+    slot.previous = tail;
+    slot.next = Handle::invalid;
+
+    if (tail == Handle::invalid)
+    {
+        head = index;
+    }
+    else
+    {
+        slots[tail].next = index;
+    }
+    tail = index;
+    count++;
+
+    return {index, slot.generation};
+}
+
+template <typename T> T SlotMap<T>::erase(Handle handle)
+{
+    auto &slot = slots[handle.index];
+
+    if (slot.previous == Handle::invalid)
+    {
+        head = slot.next;
+    }
+    else
+    {
+        slots[slot.previous].next = slot.next;
+    }
+
+    if (slot.next == Handle::invalid)
+    {
+        tail = slot.previous;
+    }
+    else
+    {
+        slots[slot.next].previous = slot.previous;
+    }
+
+    T value(std::move(slot.value));
+    slot.value = T();
+    slot.occupied = false;
+    slot.generation++;
+    slot.next_free = free_slots;
+    free_slots = handle.index;
+    count--;
+
+    return value;
+}
+
+template <typename T> T *SlotMap<T>::get(Handle handle)
+{
+    return contains(handle) ? &slots[handle.index].value : nullptr;
+}
+
+template <typename T> T const *SlotMap<T>::get(Handle handle) const
+{
+    return contains(handle) ? &slots[handle.index].value : nullptr;
+}
+
+template <typename T> bool SlotMap<T>::contains(Handle handle) const
+{
+    return handle.index < slots.size() && slots[handle.index].occupied &&
+           slots[handle.index].generation == handle.generation;
+}
+
+template <typename T> void SlotMap<T>::clear()
+{
+    while (head != Handle::invalid)
+    {
+        erase({head, slots[head].generation});
+    }
+}
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file snapshot.h
+ * @author Daniel Panero, Andrea Diez
+ * @brief Helpers of the binary snapshots of the simulation (see
+ * Simulation::save_snapshot)
+ * @version 0.1
+ * @date 2022-05-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief A snapshot is a sequence of fixed-size records, written and read back as
+ * raw bytes in the byte order of the machine: an array of records is copied in one
+ * go, without any parsing
+ *
+ */
+namespace Snapshot
+{
+    /**
+     * @brief Appends the bytes of @p value to @p out
+     *
+     */
+    template <typename T> void write(std::string &out, T const &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "not a record");
+        out.append(reinterpret_cast<char const *>(&value), sizeof(T));
+    }
+
+    /**
+     * @brief Appends the size of @p values, then their bytes, to @p out
+     *
+     */
+    template <typename T>
+    void write_array(std::string &out, std::vector<T> const &values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "not a record");
+        write(out, static_cast<uint64_t>(values.size()));
+        out.append(reinterpret_cast<char const *>(values.data()),
+                   values.size() * sizeof(T));
+    }
+
+    /**
+     * @brief Copies the next sizeof(T) bytes of [@p data, @p end) in @p value and
+     * moves @p data after them
+     *
+     * @throw std::invalid_argument if the snapshot is truncated
+     */
+    template <typename T> void read(char const *&data, char const *end, T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "not a record");
+        if (static_cast<size_t>(end - data) < sizeof(T))
+        {
+            throw std::invalid_argument("truncated snapshot");
+        }
+
+        std::memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+    }
+
+    /**
+     * @brief Same as \b read for an array written by \b write_array
+     *
+     */
+    template <typename T>
+    void read_array(char const *&data, char const *end, std::vector<T> &values)
+    {
+        uint64_t size(0);
+        read(data, end, size);
+        if (size > static_cast<uint64_t>(end - data) / sizeof(T))
+        {
+            throw std::invalid_argument("truncated snapshot");
+        }
+
+        values.resize(size);
+        std::memcpy(values.data(), data, size * sizeof(T));
+        data += size * sizeof(T);
+    }
+} // namespace Snapshot
+
+#endif
@@ -10,10 +10,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <functional>
 #include <iostream>
-#include <queue>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "error_squarecell.h"
@@ -24,21 +25,96 @@
 using std::invalid_argument;
 using std::vector;
 
-constexpr double g_max(128);
+constexpr unsigned int default_g_max(128);
+constexpr unsigned int min_g_max(16);
 
-static vector<vector<bool>> grid(g_max, vector<bool>(g_max));
+/** Largest world: the buffers indexed by cell (pathfinders, distance fields) take up
+ * to 12 bytes per cell each (see Squarecell::Pathfinder), i.e. a few hundred MB for
+ * 4096 x 4096 cells, and the cell indexes have to fit in an unsigned int */
+constexpr unsigned int max_g_max(4096);
+static_assert(uint64_t(max_g_max) * max_g_max <= UINT32_MAX);
+
+/** The grid is stored as a flat bitset: each row (y-coordinate) spans
+ * words_per_row 64-bit words and the bit i of the word w corresponds to the cell
+ * x = 64 * w + i. Setting, clearing or testing the span of a square becomes therefore
+ * a mask-and/or per row instead of walking the cells one by one */
+constexpr unsigned int word_size(64);
+
+static unsigned int g_max(default_g_max);
+static unsigned int words_per_row((g_max + word_size - 1) / word_size);
+
+static Squarecell::Grid grid(g_max * words_per_row);
+
+/** Grid read and modified by the functions of the module: the shared one, unless the
+ * calling thread has selected a copy with a GridScope */
+static thread_local Squarecell::Grid *current_grid(&grid);
+
+/**
+ * @brief Returns the mask of the bits of the word @p word that belong to the span
+ * [x, x + side)
+ *
+ * @param word index of the word in the row
+ * @param x
+ * @param side
+ * @return uint64_t
+ */
+static uint64_t span_mask(unsigned int word, unsigned int x, unsigned int side)
+{
+    unsigned int begin = std::max(x, word * word_size);
+    unsigned int end = std::min(x + side, (word + 1) * word_size);
+
+    if (begin >= end)
+    {
+        return 0;
+    }
+
+    unsigned int length = end - begin;
+    uint64_t mask = length == word_size ? ~uint64_t(0) : (uint64_t(1) << length) - 1;
+
+    return mask << (begin - word * word_size);
+}
 
 // ====================================================================================
 // Grid / Utils
 
-void Squarecell::grid_clear()
+void Squarecell::grid_clear() { std::fill(grid.begin(), grid.end(), 0); }
+
+void Squarecell::set_grid_size(unsigned int size)
 {
-    grid = vector<vector<bool>>(g_max, vector<bool>(g_max));
+    if (size < min_g_max || size > max_g_max)
+    {
+        throw invalid_argument("world size " + std::to_string(size) +
+                               " does not belong to [ " + std::to_string(min_g_max) +
+                               ", " + std::to_string(max_g_max) + " ]");
+    }
+
+    g_max = size;
+    words_per_row = (g_max + word_size - 1) / word_size;
+
+    grid = Grid(g_max * words_per_row);
+}
+
+unsigned int Squarecell::get_grid_size() { return g_max; }
+
+void Squarecell::copy_grid(Grid &copy) { copy = grid; }
+
+void Squarecell::restore_grid(Grid const &copy)
+{
+    if (copy.size() != grid.size())
+    {
+        throw invalid_argument("grid of " + std::to_string(copy.size()) +
+                               " words instead of " + std::to_string(grid.size()));
+    }
+
+    grid = copy;
+}
 
-    Graphic::clear_surface();
+Squarecell::GridScope::GridScope(Grid &copy) : previous(current_grid)
+{
+    current_grid = &copy;
 }
 
-void Squarecell::surface_clear() { Graphic::clear_surface(); }
+Squarecell::GridScope::~GridScope() { current_grid = previous; }
 
 unsigned int Squarecell::get_coordinate_x(Square const &square)
 {
@@ -128,13 +204,16 @@ void Squarecell::add_square(Square const &square)
     unsigned int x = get_coordinate_x(square);
     unsigned int y = get_coordinate_y(square);
 
-    size_t start(g_max - (y + square.side));
-    size_t end(g_max - 1 - y);
+    unsigned int first_word = x / word_size;
+    unsigned int last_word = (x + square.side - 1) / word_size;
 
-    for (size_t i(start); i <= end; i++)
+    for (unsigned int row(y); row < y + square.side; row++)
     {
-        auto &row = grid.at(i);
-        fill(row.begin() + x, row.begin() + x + square.side, true);
+        for (unsigned int word(first_word); word <= last_word; word++)
+        {
+            (*current_grid)[row * words_per_row + word] |=
+                span_mask(word, x, square.side);
+        }
     }
 }
 
@@ -143,13 +222,16 @@ void Squarecell::remove_square(Square const &square)
     unsigned int x = get_coordinate_x(square);
     unsigned int y = get_coordinate_y(square);
 
-    size_t start(g_max - (y + square.side));
-    size_t end(g_max - 1 - y);
+    unsigned int first_word = x / word_size;
+    unsigned int last_word = (x + square.side - 1) / word_size;
 
-    for (size_t i(start); i <= end; i++)
+    for (unsigned int row(y); row < y + square.side; row++)
     {
-        auto &row = grid.at(i);
-        fill(row.begin() + x, row.begin() + x + square.side, false);
+        for (unsigned int word(first_word); word <= last_word; word++)
+        {
+            (*current_grid)[row * words_per_row + word] &=
+                ~span_mask(word, x, square.side);
+        }
     }
 }
 
@@ -163,21 +245,24 @@ bool Squarecell::test_if_superposed_grid(Square const &square,
     unsigned int x = get_coordinate_x(square);
     unsigned int y = get_coordinate_y(square);
 
-    size_t start(g_max - (y + square.side));
-    size_t end(g_max - 1 - y);
+    unsigned int first_word = x / word_size;
+    unsigned int last_word = (x + square.side - 1) / word_size;
 
-    for (size_t i(start); i <= end; i++)
+    /* The rows are scanned from the top to the bottom and each row from left to right,
+     * so the reported cell is the same as the one of the cell by cell scan */
+    for (unsigned int row(y + square.side); row-- > y;)
     {
-        auto &row = grid.at(i);
-        auto cell = find(row.begin() + x, row.begin() + x + square.side, true);
-
-        /* We are comparing the iterator (cell) with the last element of the loop,
-        since C++ returns the last element when it doesn't find any matching element */
-        if (cell != row.begin() + x + square.side)
+        for (unsigned int word(first_word); word <= last_word; word++)
         {
-            superposed_x = cell - row.begin();
-            superposed_y = g_max - 1 - i;
-            return true;
+            uint64_t overlap = (*current_grid)[row * words_per_row + word] &
+                               span_mask(word, x, square.side);
+
+            if (overlap)
+            {
+                superposed_x = word * word_size + __builtin_ctzll(overlap);
+                superposed_y = row;
+                return true;
+            }
         }
     }
     return false;
@@ -286,31 +371,31 @@ bool Squarecell::test_if_border_touches(Square const &square1, Square const &squ
 // ====================================================================================
 // Search algorithms
 
-struct BFSNode
+// One per thread, so that searches can run concurrently on different grids
+static thread_local Squarecell::Pathfinder default_pathfinder;
+
+Squarecell::Square Squarecell::lee_algorithm(Square const &origin,
+                                             Square const &target,
+                                             const MoveGenerator &generate_moves,
+                                             const GoalTest &test)
 {
-    // The coordinate (x,y) of the parent, ie the first move
-    unsigned int x_i : 7;
-    unsigned int y_i : 7;
+    return default_pathfinder.lee_algorithm(origin, target, generate_moves, test);
+}
 
-    // The current coordinate (x,y) of the node
-    unsigned int x : 7;
-    unsigned int y : 7;
-};
+Squarecell::Pathfinder &Squarecell::get_pathfinder() { return default_pathfinder; }
 
-Squarecell::Square Squarecell::lee_algorithm(
-    Square const &origin, Square const &target,
-    const std::function<vector<Square>(const Square)> &generate_moves,
-    const std::function<bool(Square const &, Square const &)> &test)
+Squarecell::Square Squarecell::Pathfinder::lee_algorithm(
+    Square const &origin, Square const &target, const MoveGenerator &generate_moves,
+    const GoalTest &test)
 {
-    vector<vector<bool>> bfs_visited_nodes(g_max, vector<bool>(g_max));
-    std::queue<BFSNode> bfs_queue;
-
     if (test(origin, target))
     {
         return origin;
     }
 
-    bfs_queue.push({.x_i = origin.x, .y_i = origin.y, .x = origin.x, .y = origin.y});
+    reset();
+
+    push({.x_i = origin.x, .y_i = origin.y, .x = origin.x, .y = origin.y});
 
     /** The first time that we run the lee_algorithm algorithm, we store all the
      * valid moves / directions, so for next iterations depending on the path
@@ -319,10 +404,9 @@ Squarecell::Square Squarecell::lee_algorithm(
      */
     bool first_iteration = true;
 
-    while (!bfs_queue.empty())
+    while (queue_size != 0)
     {
-        auto bfs_current_node = bfs_queue.front();
-        bfs_queue.pop();
+        auto bfs_current_node = pop();
 
         Squarecell::Square current_square(origin);
         current_square.x = bfs_current_node.x;
@@ -337,34 +421,26 @@ Squarecell::Square Squarecell::lee_algorithm(
                     .centered = origin.centered};
         }
 
-        auto proposed_moves = generate_moves(current_square);
-        for (auto &move : proposed_moves)
+        moves.clear();
+        generate_moves(current_square, moves);
+
+        for (auto &move : moves)
         {
             // If the proposed position is valid and we have not already visited
             // it, we push into the queue
-            if (!Squarecell::test_if_superposed_grid(move))
+            if (!Squarecell::test_if_superposed_grid(move) &&
+                mark_visited(get_coordinate_x(move), get_coordinate_y(move)))
             {
-
-                unsigned int x = get_coordinate_x(move);
-                unsigned int y = get_coordinate_y(move);
-
-                bool visited = bfs_visited_nodes.at(g_max - 1 - y).at(x);
-                if (!visited)
+                if (first_iteration)
                 {
-                    if (first_iteration)
-                    {
-                        bfs_queue.push(
-                            {.x_i = move.x, .y_i = move.y, .x = move.x, .y = move.y});
-                    }
-                    else
-                    {
-                        bfs_queue.push({.x_i = bfs_current_node.x_i,
-                                        .y_i = bfs_current_node.y_i,
-                                        .x = move.x,
-                                        .y = move.y});
-                    }
-
-                    bfs_visited_nodes[g_max - 1 - y][x] = true;
+                    push({.x_i = move.x, .y_i = move.y, .x = move.x, .y = move.y});
+                }
+                else
+                {
+                    push({.x_i = bfs_current_node.x_i,
+                          .y_i = bfs_current_node.y_i,
+                          .x = move.x,
+                          .y = move.y});
                 }
             }
         }
@@ -378,64 +454,210 @@ Squarecell::Square Squarecell::lee_algorithm(
     return origin;
 }
 
-// ====================================================================================
-// Draw
+void Squarecell::Pathfinder::reset()
+{
+    if (width != g_max)
+    {
+        visited.assign(g_max * g_max, 0);
+        goals.clear();
+        cells.clear();
+        generation = 0;
+        width = g_max;
+    }
+
+    /** Instead of clearing the visited buffer, we increase the generation: a node is
+     * visited only if its stamp is equal to the current generation. Once every 65535
+     * searches the counter wraps around and we have to clear the buffer */
+    generation++;
+    if (generation == 0)
+    {
+        std::fill(visited.begin(), visited.end(), 0);
+        std::fill(goals.begin(), goals.end(), 0);
+        generation = 1;
+    }
+
+    // The capacity is always a power of two, so that we can wrap with a mask
+    size_t initial_capacity(1);
+    while (initial_capacity < 4 * g_max)
+    {
+        initial_capacity *= 2;
+    }
+
+    if (queue.size() < initial_capacity)
+    {
+        queue.resize(initial_capacity);
+    }
 
-void Squarecell::draw_as_diamond(Square const &square, const std::string &color)
+    queue_head = 0;
+    queue_size = 0;
+
+    open.clear();
+}
+
+void Squarecell::Pathfinder::reserve_goals()
 {
-    unsigned int x = get_coordinate_x(square);
-    unsigned int y = get_coordinate_y(square);
+    if (goals.empty())
+    {
+        goals.assign(width * width, 0);
+    }
+}
 
-    Graphic::draw_filled_diamond(x, y, square.side, color);
+void Squarecell::Pathfinder::reserve_cells()
+{
+    if (cells.empty())
+    {
+        cells.resize(width * width);
+    }
 }
 
-void Squarecell::draw_only_border(Square const &square, unsigned int color_index)
+void Squarecell::Pathfinder::grow()
 {
-    unsigned int x = get_coordinate_x(square);
-    unsigned int y = get_coordinate_y(square);
+    /** Each cell is pushed at most once per search, so the queue never grows beyond
+     * the number of cells, and only the first searches that need it pay for the
+     * reallocation */
+    vector<BFSNode> larger(2 * queue.size());
+    for (size_t i(0); i < queue_size; i++)
+    {
+        larger[i] = queue[(queue_head + i) & (queue.size() - 1)];
+    }
 
-    Graphic::draw_thick_border_square(x, y, square.side, color_index);
+    queue.swap(larger);
+    queue_head = 0;
 }
 
-void Squarecell::draw_filled(Square const &square, unsigned int color_index)
+unsigned long long Squarecell::Pathfinder::get_expanded_nodes() const
 {
-    unsigned int x = get_coordinate_x(square);
-    unsigned int y = get_coordinate_y(square);
+    return expanded_nodes;
+}
 
-    Graphic::draw_filled_square(x, y, square.side, color_index);
+void Squarecell::DistanceField::reset()
+{
+    if (width != g_max)
+    {
+        width = g_max;
+        distances.resize(g_max * g_max);
+    }
+
+    std::fill(distances.begin(), distances.end(), unreachable);
+    queue.clear();
 }
 
-void Squarecell::draw_diagonal_pattern(Square const &square, unsigned int color_index)
+void Squarecell::DistanceField::add_goal(Square const &position)
 {
-    unsigned int x = get_coordinate_x(square);
-    unsigned int y = get_coordinate_y(square);
+    if (!test_square_without_message(position))
+    {
+        return;
+    }
 
-    Graphic::draw_diagonal_pattern_square(x, y, square.side, color_index);
+    auto &distance = distances[position.y * width + position.x];
+    if (distance != 0 && !test_if_superposed_grid(position))
+    {
+        distance = 0;
+        queue.push_back(position.y * width + position.x);
+    }
 }
 
-void Squarecell::draw_plus_pattern(Square const &square, unsigned int color_index)
+uint32_t Squarecell::DistanceField::get_distance(Square const &position) const
 {
-    unsigned int x = get_coordinate_x(square);
-    unsigned int y = get_coordinate_y(square);
+    if (width != g_max || !test_square_without_message(position))
+    {
+        return unreachable;
+    }
 
-    Graphic::draw_plus_pattern_square(x, y, square.side, color_index);
+    return distances[position.y * width + position.x];
+}
+
+void Squarecell::BucketGrid::clear()
+{
+    unsigned int new_width = (g_max + block - 1) / block;
+    if (width != new_width)
+    {
+        width = new_width;
+        buckets.resize(width * width);
+    }
+
+    for (auto &bucket : buckets)
+    {
+        bucket.clear();
+    }
+    max_side = 0;
+}
+
+void Squarecell::BucketGrid::insert(Square const &square, unsigned int id)
+{
+    unsigned int x = get_coordinate_x(square) / block;
+    unsigned int y = get_coordinate_y(square) / block;
+
+    buckets[y * width + x].push_back(id);
+    max_side = std::max(max_side, square.side);
+}
+
+void Squarecell::BucketGrid::query(Square const &region, unsigned int margin,
+                                   vector<unsigned int> &ids) const
+{
+    if (width == 0)
+    {
+        return;
+    }
+
+    /* A square superposes the enlarged region only if its corner is at most
+     * max_side cells before it */
+    unsigned int before = margin + max_side;
+    unsigned int x = get_coordinate_x(region);
+    unsigned int y = get_coordinate_y(region);
+
+    unsigned int x_min = (x > before ? x - before : 0) / block;
+    unsigned int y_min = (y > before ? y - before : 0) / block;
+    unsigned int x_max = std::min((x + region.side + margin) / block, width - 1);
+    unsigned int y_max = std::min((y + region.side + margin) / block, width - 1);
+
+    size_t first = ids.size();
+    for (unsigned int j(y_min); j <= y_max; j++)
+    {
+        for (unsigned int i(x_min); i <= x_max; i++)
+        {
+            auto const &bucket = buckets[j * width + i];
+            ids.insert(ids.end(), bucket.begin(), bucket.end());
+        }
+    }
+
+    std::sort(ids.begin() + first, ids.end());
 }
 
 // ====================================================================================
-// Undraw
+// Draw
 
-void Squarecell::undraw_square(Square const &square)
+void Squarecell::draw_as_diamond(Graphic::Frame &frame, Square const &square,
+                                 unsigned int color_index)
 {
-    unsigned int x = get_coordinate_x(square);
-    unsigned int y = get_coordinate_y(square);
+    frame.push_back({Graphic::DIAMOND, get_coordinate_x(square),
+                     get_coordinate_y(square), square.side, color_index});
+}
 
-    Graphic::undraw_square(x, y, square.side);
+void Squarecell::draw_only_border(Graphic::Frame &frame, Square const &square,
+                                  unsigned int color_index)
+{
+    frame.push_back({Graphic::THICK_BORDER, get_coordinate_x(square),
+                     get_coordinate_y(square), square.side, color_index});
 }
 
-void Squarecell::undraw_thick_border_square(Square const &square)
+void Squarecell::draw_filled(Graphic::Frame &frame, Square const &square,
+                             unsigned int color_index)
 {
-    unsigned int x = get_coordinate_x(square);
-    unsigned int y = get_coordinate_y(square);
+    frame.push_back({Graphic::FILLED, get_coordinate_x(square),
+                     get_coordinate_y(square), square.side, color_index});
+}
 
-    Graphic::undraw_thick_border_square(x, y, square.side);
+void Squarecell::draw_diagonal_pattern(Graphic::Frame &frame, Square const &square,
+                                       unsigned int color_index)
+{
+    frame.push_back({Graphic::DIAGONAL_PATTERN, get_coordinate_x(square),
+                     get_coordinate_y(square), square.side, color_index});
+}
+
+void Squarecell::draw_plus_pattern(Graphic::Frame &frame, Square const &square,
+                                   unsigned int color_index)
+{
+    frame.push_back({Graphic::PLUS_PATTERN, get_coordinate_x(square),
+                     get_coordinate_y(square), square.side, color_index});
 }
\ No newline at end of file
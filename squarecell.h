@@ -11,9 +11,14 @@
 #ifndef SQUARECELL_H
 #define SQUARECELL_H
 
+#include <algorithm>
+#include <climits>
+#include <cstdint>
 #include <functional>
 #include <vector>
 
+#include "graphic.h"
+
 namespace Squarecell
 {
     struct Square
@@ -25,12 +30,61 @@ namespace Squarecell
     };
 
     /**
-     * @brief Resets the grid and clears the surface of Graphic
+     * @brief Resets the grid
      *
      */
     void grid_clear();
 
-    void surface_clear();
+    /**
+     * @brief Sets the size of the world (number of cells of a side) and resets the
+     * grid. It has to be called before any element is added to the grid
+     *
+     * @param size
+     */
+    void set_grid_size(unsigned int size);
+    unsigned int get_grid_size();
+
+    /**
+     * @brief Occupancy of the cells, one bit per cell (see squarecell.cc)
+     *
+     */
+    using Grid = std::vector<uint64_t>;
+
+    /**
+     * @brief Copies the shared grid in @p copy
+     *
+     * @param[out] copy
+     */
+    void copy_grid(Grid &copy);
+
+    /**
+     * @brief Replaces the shared grid by @p copy, obtained with \b copy_grid for the
+     * same grid size
+     *
+     * @param copy
+     * @throw std::invalid_argument if @p copy doesn't have the size of the grid
+     */
+    void restore_grid(Grid const &copy);
+
+    /**
+     * @brief While it exists, @p copy (obtained with \b copy_grid) is the grid read
+     * and modified by all the functions of the module called from the thread that
+     * created it, instead of the shared grid. It lets several threads work on their
+     * own version of the world at the same time
+     *
+     */
+    class GridScope
+    {
+    public:
+        explicit GridScope(Grid &copy);
+        ~GridScope();
+
+        GridScope(GridScope const &) = delete;
+        GridScope &operator=(GridScope const &) = delete;
+
+    private:
+        Grid *previous;
+    };
 
     /**
      * @brief Calculates the bottom left x-coordinate.
@@ -110,85 +164,980 @@ namespace Squarecell
      */
     bool test_if_border_touches(Square const &square1, Square const &square2);
 
+    /**
+     * @brief Appends to the vector all the possible moves from the given square
+     */
+    using MoveGenerator = std::function<void(Square const &, std::vector<Square> &)>;
+    using GoalTest = std::function<bool(Square const &, Square const &)>;
+
     /**
      * @brief Implementation of a lee algorithm, used for solving maze routing problems
      * based on breadth-first search. It always gives an optimal solution, if one
      * exists, but is slow and requires considerable memory. The algorithm search all
      * possible routes generates via the function \b generate_moves and when it has
      * reached its goal ( \b test true), it returns the first move / position for
-     * taking the optmal path
+     * taking the optmal path. Under the hood, it uses a shared \b Pathfinder
      *
      * @param origin
      * @param target
-     * @param generate_moves a function that returns all the possible moves based on
+     * @param generate_moves a function that appends all the possible moves based on
      * the current position
      * @param test a function which that if the algorithm has reached its goal
      * @return Squarecell::Square
      */
-    Squarecell::Square lee_algorithm(
-        Square const &origin, Square const &target,
-        const std::function<std::vector<Square>(const Square)> &generate_moves,
-        const std::function<bool(Square const &, Square const &)> &test);
+    Squarecell::Square lee_algorithm(Square const &origin, Square const &target,
+                                     const MoveGenerator &generate_moves,
+                                     const GoalTest &test);
 
     /**
-     * @brief Draws @p square as diamond using the module Graphic
+     * @brief Same as \b lee_algorithm, but the moves are known at compile-time and the
+     * goal test is inlined, so that expanding a node doesn't go through any indirect
+     * call
      *
-     * @param square
-     * @param color
+     * @tparam Moves policy with the static constexpr arrays x_shift and y_shift of
+     * size n (e.g: Collector::Moves)
+     * @tparam Test callable with signature bool(Square const &, Square const &)
+     * @param origin
+     * @param target
+     * @param test
+     * @return Squarecell::Square
      */
-    void draw_as_diamond(Square const &square, const std::string &color);
+    template <typename Moves, typename Test>
+    Squarecell::Square lee_algorithm(Square const &origin, Square const &target,
+                                     Test test);
 
     /**
-     * @brief Draws @p square as a thick border of color @p color_index using the
-     * module Graphic
+     * @brief Same as \b lee_algorithm<Moves, Test>, but towards the nearest of
+     * several targets: the search stops at the first position for which @p test is
+     * true with any of @p targets. The grid is not modified, so the goal positions
+     * have to be free
      *
-     * @param square
-     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan)
+     * @tparam Moves
+     * @tparam Test same as \b find_path, it can only be true for positions touching
+     * or superposing the target
+     * @param origin
+     * @param targets
+     * @param test
+     * @return Squarecell::Square
+     */
+    template <typename Moves, typename Test>
+    Squarecell::Square lee_algorithm(Square const &origin,
+                                     std::vector<Square> const &targets, Test test);
+
+    /**
+     * @brief Search engines available for \b find_path
+     *
+     */
+    enum Engine
+    {
+        LEE,
+        ASTAR
+    };
+
+    /**
+     * @brief Same as \b lee_algorithm<Moves, Test>, but it can use an A* search
+     * instead: the paths found have the same length and in case of a tie, the first
+     * move returned is the same as the one of \b lee_algorithm. The A* search
+     * requires that @p test can only be true for positions touching or superposing
+     * @p target
+     *
+     * @tparam Moves same as \b lee_algorithm, with in addition a static function
+     * heuristic(dx, dy), which is a lower bound of the number of moves needed to
+     * close a gap of dx (dy) cells in the x-axis (y-axis)
+     * @tparam Test
+     * @param origin
+     * @param target
+     * @param test
+     * @param engine
+     * @return Squarecell::Square
+     */
+    template <typename Moves, typename Test>
+    Squarecell::Square find_path(Square const &origin, Square const &target, Test test,
+                                 Engine engine);
+
+    /**
+     * @brief Same as \b find_path, but towards the nearest of several targets (see
+     * \b lee_algorithm with several targets). The heuristic of the A* search is the
+     * lowest one among the targets
+     *
+     */
+    template <typename Moves, typename Test>
+    Squarecell::Square find_path(Square const &origin,
+                                 std::vector<Square> const &targets, Test test,
+                                 Engine engine);
+
+    /**
+     * @brief Search engine behind \b lee_algorithm. It owns all the buffers needed by
+     * a search (visited nodes, queue, proposed moves), which are allocated once and
+     * then reused, so that a search doesn't allocate any memory. There is one per
+     * searching thread (see \b get_pathfinder): it takes 2 bytes per cell of the
+     * world, plus 2 bytes per cell once it did a multi-target search and 8 bytes per
+     * cell once it did an A* search, i.e. at most 192 MB for the largest world
+     *
+     */
+    class Pathfinder
+    {
+    public:
+        /**
+         * @brief Same as \b Squarecell::lee_algorithm
+         */
+        Square lee_algorithm(Square const &origin, Square const &target,
+                             const MoveGenerator &generate_moves,
+                             const GoalTest &test);
+
+        /**
+         * @brief Same as \b Squarecell::lee_algorithm<Moves, Test>
+         */
+        template <typename Moves, typename Test>
+        Square lee_algorithm(Square const &origin, Square const &target, Test test);
+
+        /**
+         * @brief Same as \b Squarecell::lee_algorithm<Moves, Test> with several
+         * targets
+         */
+        template <typename Moves, typename Test>
+        Square lee_algorithm(Square const &origin, std::vector<Square> const &targets,
+                             Test test);
+
+        /**
+         * @brief A* search used by \b Squarecell::find_path. The nodes are ordered by
+         * estimated length of the path and then by index of the first move, which
+         * gives the same tie-break as the breadth-first search
+         */
+        template <typename Moves, typename Test>
+        Square a_star(Square const &origin, Square const &target, Test test);
+
+        /**
+         * @brief Same as \b a_star with several targets
+         */
+        template <typename Moves, typename Test>
+        Square a_star(Square const &origin, std::vector<Square> const &targets,
+                      Test test);
+
+        /**
+         * @brief Returns the number of nodes expanded (popped from the queue) by all
+         * the searches done with this instance
+         *
+         * @return unsigned long long
+         */
+        unsigned long long get_expanded_nodes() const;
+
+    private:
+        struct BFSNode
+        {
+            // The coordinate (x,y) of the parent, ie the first move
+            unsigned int x_i : 16;
+            unsigned int y_i : 16;
+
+            // The current coordinate (x,y) of the node
+            unsigned int x : 16;
+            unsigned int y : 16;
+        };
+
+        struct AStarNode
+        {
+            // Estimated length of the path: g + heuristic
+            uint32_t f;
+            uint32_t g;
+            uint8_t first_move;
+
+            uint16_t x;
+            uint16_t y;
+
+            /**
+             * @brief Ordering of the priority queue (std::push_heap is a max-heap)
+             *
+             * @return true if @p a has to be expanded after @p b
+             */
+            static bool compare(AStarNode const &a, AStarNode const &b)
+            {
+                return a.f != b.f ? a.f > b.f : a.first_move > b.first_move;
+            }
+        };
+
+        struct AStarCell
+        {
+            uint32_t g;
+            uint8_t first_move;
+            bool closed;
+        };
+
+        /**
+         * @brief Returns the number of free cells between the segments [@p a, @p a +
+         * @p side_a[ and [@p b, @p b + @p side_b[
+         *
+         */
+        static unsigned int get_gap(unsigned int a, unsigned int side_a,
+                                    unsigned int b, unsigned int side_b)
+        {
+            if (b > a + side_a)
+            {
+                return b - a - side_a;
+            }
+            if (a > b + side_b)
+            {
+                return a - b - side_b;
+            }
+
+            return 0;
+        }
+
+        /**
+         * @brief Prepares the buffers for a new search: sizes them to the grid and
+         * starts a new generation of visited nodes
+         *
+         */
+        void reset();
+
+        /**
+         * @brief Sizes \b goals (resp. \b cells) to the grid the first time they are
+         * needed, so that the pathfinders which never do a multi-target (resp. A*)
+         * search don't pay for them. To be called after \b reset
+         *
+         */
+        void reserve_goals();
+        void reserve_cells();
+
+        /**
+         * @brief Marks the cell (x,y) as visited
+         *
+         * @return false if it was already visited during this search
+         */
+        bool mark_visited(unsigned int x, unsigned int y)
+        {
+            auto &stamp = visited[y * width + x];
+            if (stamp == generation)
+            {
+                return false;
+            }
+
+            stamp = generation;
+            return true;
+        }
+
+        void push(BFSNode const &node)
+        {
+            if (queue_size == queue.size())
+            {
+                grow();
+            }
+
+            queue[(queue_head + queue_size) & (queue.size() - 1)] = node;
+            queue_size++;
+        }
+
+        BFSNode pop()
+        {
+            auto node = queue[queue_head];
+
+            queue_head = (queue_head + 1) & (queue.size() - 1);
+            queue_size--;
+            expanded_nodes++;
+
+            return node;
+        }
+
+        /**
+         * @brief Doubles the capacity of the queue, keeping the order of the nodes
+         *
+         */
+        void grow();
+
+        /**
+         * @brief Marks in \b goals the positions of a square like @p origin for which
+         * @p test is true with any of @p targets. To be called after \b reserve_goals
+         *
+         * @return true if @p origin is one of them
+         */
+        template <typename Test>
+        bool mark_goals(Square const &origin, std::vector<Square> const &targets,
+                        Test test);
+
+        /**
+         * @brief Body of the A* searches, from @p origin until the first position for
+         * which @p goal is true. To be called after \b reserve_cells
+         *
+         * @tparam Estimate callable with signature unsigned int(Square const &), a
+         * lower bound of the number of moves to a goal
+         * @tparam Goal callable with signature bool(Square const &)
+         */
+        template <typename Moves, typename Estimate, typename Goal>
+        Square a_star_search(Square const &origin, Estimate estimate, Goal goal);
+
+        /**
+         * @brief Generation stamp of each cell (indexed by y * width + x): a cell is
+         * visited if its stamp is equal to \b generation
+         *
+         */
+        std::vector<uint16_t> visited;
+        uint16_t generation = 0;
+
+        /**
+         * @brief Same as \b visited for the goal positions of the multi-target search,
+         * empty until the first one
+         *
+         */
+        std::vector<uint16_t> goals;
+        unsigned int width = 0;
+
+        /**
+         * @brief Ring buffer used as queue, its capacity is always a power of two
+         *
+         */
+        std::vector<BFSNode> queue;
+        size_t queue_head = 0;
+        size_t queue_size = 0;
+
+        std::vector<Square> moves;
+
+        /**
+         * @brief Best path found to each cell by the A* search, only valid if the cell
+         * is visited (empty until the first A* search)
+         *
+         */
+        std::vector<AStarCell> cells;
+        std::vector<AStarNode> open;
+
+        unsigned long long expanded_nodes = 0;
+    };
+
+    /**
+     * @brief Distance (number of moves) from every position to the nearest goal,
+     * computed once with a reverse breadth-first search and then shared by all the
+     * ants that have the same goal: each of them just has to step to its neighbour
+     * with the lowest distance (see \b descend). The distances take 4 bytes per cell:
+     * a path with detours can be much longer than the side of the world
+     *
+     */
+    class DistanceField
+    {
+    public:
+        static constexpr uint32_t unreachable = 0xFFFFFFFF;
+
+        /**
+         * @brief Computes the field for an ant with the same side as @p model. The
+         * goals are the free positions inside @p region for which @p test (position,
+         * target) is true
+         *
+         * @tparam Moves same as \b lee_algorithm
+         * @tparam Test same as \b lee_algorithm
+         * @param model square with the side / centering of the ant
+         * @param target
+         * @param region the (not centered) square where the goals are searched
+         * @param test
+         */
+        template <typename Moves, typename Test>
+        void compute(Square const &model, Square const &target, Square const &region,
+                     Test test);
+
+        /**
+         * @brief Computes the field from an explicit list of goals, the positions of
+         * @p goals that are not valid or not free are ignored
+         *
+         * @tparam Moves same as \b lee_algorithm
+         * @param model square with the side / centering of the ant
+         * @param goals
+         */
+        template <typename Moves>
+        void compute(Square const &model, std::vector<Square> const &goals);
+
+        /**
+         * @brief Returns the free neighbour of @p origin with the lowest distance
+         * (the first one following the order of @p Moves in case of a tie) or @p
+         * origin if none of them can reach a goal
+         *
+         * @tparam Moves
+         * @param origin
+         * @return Square
+         */
+        template <typename Moves> Square descend(Square const &origin) const;
+
+        uint32_t get_distance(Square const &position) const;
+
+    private:
+        void reset();
+
+        /**
+         * @brief Sets the distance of @p position to 0 if it is valid, free and not
+         * already a goal
+         *
+         */
+        void add_goal(Square const &position);
+
+        /**
+         * @brief Breadth-first search from the goals added since the last \b reset
+         *
+         */
+        template <typename Moves> void expand(Square const &model);
+
+        std::vector<uint32_t> distances;
+        unsigned int width = 0;
+
+        std::vector<unsigned int> queue;
+    };
+
+    /**
+     * @brief Uniform grid of buckets of block x block cells, each bucket holds the
+     * ids of the squares whose bottom-left corner lies in it. It is rebuilt (\b
+     * clear and \b insert) whenever the squares move, the buckets keep their memory
+     * between the rebuilds
+     *
+     */
+    class BucketGrid
+    {
+    public:
+        static constexpr unsigned int block = 8;
+
+        /**
+         * @brief Removes all the ids and adapts the number of buckets to the size of
+         * the world
+         *
+         */
+        void clear();
+
+        void insert(Square const &square, unsigned int id);
+
+        /**
+         * @brief Appends to @p ids (in increasing order) the ids of all the squares
+         * that superpose @p region enlarged by @p margin cells on every side. Some
+         * squares further away may be returned as well
+         *
+         * @param region
+         * @param margin
+         * @param ids
+         */
+        void query(Square const &region, unsigned int margin,
+                   std::vector<unsigned int> &ids) const;
+
+    private:
+        std::vector<std::vector<unsigned int>> buckets;
+        unsigned int width = 0;
+
+        // Largest side inserted since the last clear
+        unsigned int max_side = 0;
+    };
+
+    /**
+     * @brief Returns the Pathfinder shared by \b lee_algorithm (one per thread)
+     *
+     * @return Pathfinder&
      */
-    void draw_only_border(Square const &square, unsigned int color_index);
+    Pathfinder &get_pathfinder();
 
     /**
-     * @brief Fills @p square with the color @p color_index using the
-     * module Graphic
+     * @brief Appends to @p frame @p square drawn as diamond
      *
+     * @param frame
      * @param square
-     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan)
+     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan) or
+     * Graphic::white
      */
-    void draw_filled(Square const &square, unsigned int color_index);
+    void draw_as_diamond(Graphic::Frame &frame, Square const &square,
+                         unsigned int color_index);
 
     /**
-     * @brief Draws @p square filled with |X O||X O|... pattern where X has color @p
-     * color_index and O a lighter version of @p color_index using the
-     * module Graphic
+     * @brief Appends to @p frame @p square drawn as a thick border of color @p
+     * color_index
      *
+     * @param frame
      * @param square
      * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan)
      */
-    void draw_diagonal_pattern(Square const &square, unsigned int color_index);
+    void draw_only_border(Graphic::Frame &frame, Square const &square,
+                          unsigned int color_index);
 
     /**
-     * @brief Draws @p square filled with a lighter version of @p color_index and a
-     * plus sign in the center with color @p color_index using the
-     * module Graphic
+     * @brief Appends to @p frame @p square filled with the color @p color_index
      *
+     * @param frame
      * @param square
      * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan)
      */
-    void draw_plus_pattern(Square const &square, unsigned int color_index);
+    void draw_filled(Graphic::Frame &frame, Square const &square,
+                     unsigned int color_index);
 
     /**
-     * @brief Erases everything drawn on the area of the square
+     * @brief Appends to @p frame @p square filled with |X O||X O|... pattern where X
+     * has color @p color_index and O a lighter version of @p color_index
      *
+     * @param frame
      * @param square
+     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan)
      */
-    void undraw_square(Square const &square);
+    void draw_diagonal_pattern(Graphic::Frame &frame, Square const &square,
+                               unsigned int color_index);
 
     /**
-     * @brief Erases the thick border of the square
+     * @brief Appends to @p frame @p square filled with a lighter version of @p
+     * color_index and a plus sign in the center with color @p color_index
      *
+     * @param frame
      * @param square
+     * @param color_index (0 red, 1 green, 2 blue, 3 yellow, 4 magenta, 5 cyan)
      */
-    void undraw_thick_border_square(Square const &square);
+    void draw_plus_pattern(Graphic::Frame &frame, Square const &square,
+                           unsigned int color_index);
 } // namespace Squarecell
 
+// ====================================================================================
+// Templates implementation
+
+template <typename Moves, typename Test>
+Squarecell::Square Squarecell::lee_algorithm(Square const &origin,
+                                             Square const &target, Test test)
+{
+    return get_pathfinder().lee_algorithm<Moves>(origin, target, test);
+}
+
+template <typename Moves, typename Test>
+Squarecell::Square Squarecell::Pathfinder::lee_algorithm(Square const &origin,
+                                                         Square const &target,
+                                                         Test test)
+{
+    if (test(origin, target))
+    {
+        return origin;
+    }
+
+    reset();
+
+    push({.x_i = origin.x, .y_i = origin.y, .x = origin.x, .y = origin.y});
+
+    // See the non-templated version: the order of the expansion is the same
+    bool first_iteration = true;
+
+    while (queue_size != 0)
+    {
+        auto bfs_current_node = pop();
+
+        Square current_square(origin);
+        current_square.x = bfs_current_node.x;
+        current_square.y = bfs_current_node.y;
+
+        if (test(current_square, target))
+        {
+            return {.x = bfs_current_node.x_i,
+                    .y = bfs_current_node.y_i,
+                    .side = origin.side,
+                    .centered = origin.centered};
+        }
+
+        for (size_t i(0); i < Moves::n; i++)
+        {
+            Square move(current_square);
+            move.x += Moves::x_shift[i];
+            move.y += Moves::y_shift[i];
+
+            if (test_square_without_message(move) && !test_if_superposed_grid(move) &&
+                mark_visited(get_coordinate_x(move), get_coordinate_y(move)))
+            {
+                if (first_iteration)
+                {
+                    push({.x_i = move.x, .y_i = move.y, .x = move.x, .y = move.y});
+                }
+                else
+                {
+                    push({.x_i = bfs_current_node.x_i,
+                          .y_i = bfs_current_node.y_i,
+                          .x = move.x,
+                          .y = move.y});
+                }
+            }
+        }
+
+        first_iteration = false;
+    }
+
+    return origin;
+}
+
+template <typename Moves, typename Test>
+Squarecell::Square Squarecell::lee_algorithm(Square const &origin,
+                                             std::vector<Square> const &targets,
+                                             Test test)
+{
+    return get_pathfinder().lee_algorithm<Moves>(origin, targets, test);
+}
+
+template <typename Moves, typename Test>
+Squarecell::Square
+Squarecell::Pathfinder::lee_algorithm(Square const &origin,
+                                      std::vector<Square> const &targets, Test test)
+{
+    reset();
+    reserve_goals();
+
+    if (mark_goals(origin, targets, test))
+    {
+        return origin;
+    }
+
+    push({.x_i = origin.x, .y_i = origin.y, .x = origin.x, .y = origin.y});
+
+    // See the non-templated version: the order of the expansion is the same
+    bool first_iteration = true;
+
+    while (queue_size != 0)
+    {
+        auto bfs_current_node = pop();
+
+        Square current_square(origin);
+        current_square.x = bfs_current_node.x;
+        current_square.y = bfs_current_node.y;
+
+        for (size_t i(0); i < Moves::n; i++)
+        {
+            Square move(current_square);
+            move.x += Moves::x_shift[i];
+            move.y += Moves::y_shift[i];
+
+            unsigned int move_x = get_coordinate_x(move);
+            unsigned int move_y = get_coordinate_y(move);
+
+            if (!test_square_without_message(move) || test_if_superposed_grid(move) ||
+                !mark_visited(move_x, move_y))
+            {
+                continue;
+            }
+
+            BFSNode node{.x_i = bfs_current_node.x_i,
+                         .y_i = bfs_current_node.y_i,
+                         .x = move.x,
+                         .y = move.y};
+            if (first_iteration)
+            {
+                node.x_i = move.x;
+                node.y_i = move.y;
+            }
+
+            /* The nodes are pushed in the same order as they would be expanded, so
+             * the search can already stop at the first goal pushed */
+            if (goals[move_y * width + move_x] == generation)
+            {
+                return {.x = node.x_i,
+                        .y = node.y_i,
+                        .side = origin.side,
+                        .centered = origin.centered};
+            }
+
+            push(node);
+        }
+
+        first_iteration = false;
+    }
+
+    return origin;
+}
+
+template <typename Moves, typename Test>
+Squarecell::Square Squarecell::find_path(Square const &origin, Square const &target,
+                                         Test test, Engine engine)
+{
+    if (engine == ASTAR)
+    {
+        return get_pathfinder().a_star<Moves>(origin, target, test);
+    }
+
+    return get_pathfinder().lee_algorithm<Moves>(origin, target, test);
+}
+
+template <typename Moves, typename Test>
+Squarecell::Square Squarecell::find_path(Square const &origin,
+                                         std::vector<Square> const &targets, Test test,
+                                         Engine engine)
+{
+    if (engine == ASTAR)
+    {
+        return get_pathfinder().a_star<Moves>(origin, targets, test);
+    }
+
+    return get_pathfinder().lee_algorithm<Moves>(origin, targets, test);
+}
+
+template <typename Moves, typename Test>
+Squarecell::Square Squarecell::Pathfinder::a_star(Square const &origin,
+                                                  Square const &target, Test test)
+{
+    if (test(origin, target))
+    {
+        return origin;
+    }
+
+    reset();
+    reserve_cells();
+
+    unsigned int target_x = get_coordinate_x(target);
+    unsigned int target_y = get_coordinate_y(target);
+
+    auto estimate = [&](Square const &square)
+    {
+        return Moves::heuristic(
+            get_gap(get_coordinate_x(square), square.side, target_x, target.side),
+            get_gap(get_coordinate_y(square), square.side, target_y, target.side));
+    };
+
+    return a_star_search<Moves>(origin, estimate,
+                                [&](Square const &square)
+                                { return test(square, target); });
+}
+
+template <typename Moves, typename Test>
+Squarecell::Square
+Squarecell::Pathfinder::a_star(Square const &origin,
+                               std::vector<Square> const &targets, Test test)
+{
+    reset();
+    reserve_goals();
+
+    if (mark_goals(origin, targets, test))
+    {
+        return origin;
+    }
+
+    reserve_cells();
+
+    auto estimate = [&](Square const &square)
+    {
+        unsigned int lowest = UINT_MAX;
+        for (auto const &target : targets)
+        {
+            unsigned int dx = get_gap(get_coordinate_x(square), square.side,
+                                      get_coordinate_x(target), target.side);
+            unsigned int dy = get_gap(get_coordinate_y(square), square.side,
+                                      get_coordinate_y(target), target.side);
+
+            lowest = std::min(lowest, Moves::heuristic(dx, dy));
+        }
+
+        return lowest;
+    };
+
+    auto goal = [&](Square const &square)
+    {
+        return goals[get_coordinate_y(square) * width + get_coordinate_x(square)] ==
+               generation;
+    };
+
+    return a_star_search<Moves>(origin, estimate, goal);
+}
+
+template <typename Test>
+bool Squarecell::Pathfinder::mark_goals(Square const &origin,
+                                        std::vector<Square> const &targets, Test test)
+{
+    /* As they touch or superpose a target, the goal positions are all inside the
+     * target enlarged by the side of the origin */
+    bool reached = false;
+    for (auto const &target : targets)
+    {
+        int target_x = get_coordinate_x(target);
+        int target_y = get_coordinate_y(target);
+        int shift = origin.centered ? (origin.side - 1) / 2 : 0;
+
+        for (int y(target_y - origin.side); y <= target_y + int(target.side); y++)
+        {
+            for (int x(target_x - origin.side); x <= target_x + int(target.side); x++)
+            {
+                if (x < 0 || y < 0 || x >= int(width) || y >= int(width))
+                {
+                    continue;
+                }
+
+                Square position(origin);
+                position.x = x + shift;
+                position.y = y + shift;
+
+                if (test_square_without_message(position) && test(position, target))
+                {
+                    goals[y * width + x] = generation;
+                    reached = reached || (position.x == origin.x &&
+                                          position.y == origin.y);
+                }
+            }
+        }
+    }
+
+    return reached;
+}
+
+template <typename Moves, typename Estimate, typename Goal>
+Squarecell::Square Squarecell::Pathfinder::a_star_search(Square const &origin,
+                                                         Estimate estimate, Goal goal)
+{
+    // The first move of the origin is Moves::n, as it has not moved yet
+    mark_visited(get_coordinate_x(origin), get_coordinate_y(origin));
+    cells[get_coordinate_y(origin) * width + get_coordinate_x(origin)] = {0, Moves::n,
+                                                                          false};
+    open.push_back({estimate(origin), 0, Moves::n, static_cast<uint16_t>(origin.x),
+                    static_cast<uint16_t>(origin.y)});
+
+    while (!open.empty())
+    {
+        std::pop_heap(open.begin(), open.end(), AStarNode::compare);
+        auto node = open.back();
+        open.pop_back();
+
+        Square current_square(origin);
+        current_square.x = node.x;
+        current_square.y = node.y;
+
+        /* A cell can be pushed several times if a better path is found later, only
+         * the best one is expanded */
+        auto &cell = cells[get_coordinate_y(current_square) * width +
+                           get_coordinate_x(current_square)];
+        if (cell.closed || cell.g != node.g || cell.first_move != node.first_move)
+        {
+            continue;
+        }
+
+        cell.closed = true;
+        expanded_nodes++;
+
+        if (goal(current_square))
+        {
+            Square move(origin);
+            move.x += Moves::x_shift[node.first_move];
+            move.y += Moves::y_shift[node.first_move];
+
+            return move;
+        }
+
+        for (size_t i(0); i < Moves::n; i++)
+        {
+            Square move(current_square);
+            move.x += Moves::x_shift[i];
+            move.y += Moves::y_shift[i];
+
+            if (!test_square_without_message(move) || test_if_superposed_grid(move))
+            {
+                continue;
+            }
+
+            AStarCell candidate{node.g + 1,
+                                static_cast<uint8_t>(node.first_move == Moves::n
+                                                         ? i
+                                                         : node.first_move),
+                                false};
+
+            auto &neighbour =
+                cells[get_coordinate_y(move) * width + get_coordinate_x(move)];
+            if (mark_visited(get_coordinate_x(move), get_coordinate_y(move)) ||
+                (!neighbour.closed &&
+                 (candidate.g < neighbour.g ||
+                  (candidate.g == neighbour.g &&
+                   candidate.first_move < neighbour.first_move))))
+            {
+                neighbour = candidate;
+
+                open.push_back({candidate.g + estimate(move), candidate.g,
+                                candidate.first_move, static_cast<uint16_t>(move.x),
+                                static_cast<uint16_t>(move.y)});
+                std::push_heap(open.begin(), open.end(), AStarNode::compare);
+            }
+        }
+    }
+
+    return origin;
+}
+
+template <typename Moves, typename Test>
+void Squarecell::DistanceField::compute(Square const &model, Square const &target,
+                                        Square const &region, Test test)
+{
+    reset();
+
+    unsigned int x_end = std::min(region.x + region.side, width);
+    unsigned int y_end = std::min(region.y + region.side, width);
+
+    for (unsigned int y(region.y); y < y_end; y++)
+    {
+        for (unsigned int x(region.x); x < x_end; x++)
+        {
+            Square position(model);
+            position.x = x;
+            position.y = y;
+
+            if (test(position, target))
+            {
+                add_goal(position);
+            }
+        }
+    }
+
+    expand<Moves>(model);
+}
+
+template <typename Moves>
+void Squarecell::DistanceField::compute(Square const &model,
+                                        std::vector<Square> const &goals)
+{
+    reset();
+
+    for (auto const &goal : goals)
+    {
+        add_goal(goal);
+    }
+
+    expand<Moves>(model);
+}
+
+template <typename Moves> void Squarecell::DistanceField::expand(Square const &model)
+{
+    for (size_t head(0); head < queue.size(); head++)
+    {
+        unsigned int cell = queue[head];
+        uint32_t distance = distances[cell];
+
+        for (size_t i(0); i < Moves::n; i++)
+        {
+            /* Reverse search: we look for the positions from which the move i leads
+             * to the current cell */
+            Square position(model);
+            position.x = cell % width - Moves::x_shift[i];
+            position.y = cell / width - Moves::y_shift[i];
+
+            if (!test_square_without_message(position))
+            {
+                continue;
+            }
+
+            auto &neighbour = distances[position.y * width + position.x];
+            if (neighbour == unreachable && !test_if_superposed_grid(position))
+            {
+                neighbour = distance + 1;
+                queue.push_back(position.y * width + position.x);
+            }
+        }
+    }
+}
+
+template <typename Moves>
+Squarecell::Square Squarecell::DistanceField::descend(Square const &origin) const
+{
+    Square best(origin);
+    uint32_t best_distance = unreachable;
+
+    if (width != get_grid_size())
+    {
+        return best;
+    }
+
+    for (size_t i(0); i < Moves::n; i++)
+    {
+        Square move(origin);
+        move.x += Moves::x_shift[i];
+        move.y += Moves::y_shift[i];
+
+        if (test_square_without_message(move) &&
+            distances[move.y * width + move.x] < best_distance &&
+            !test_if_superposed_grid(move))
+        {
+            best = move;
+            best_distance = distances[move.y * width + move.x];
+        }
+    }
+
+    return best;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#!/bin/bash
+
+# Runs every valid scenario with the Lee algorithm and with the A* search for all the
+# ant types that support it, and checks that both give the same final state
+
+folders=(
+    "tests/correct_txt/"
+    "tests/correct_txt/R3_tests/"
+)
+ticks=500
+engines="generator,defensor,predator"
+
+total=0
+failed=0
+
+echo Compiling projects files
+cd ../
+make HEADLESS=true
+
+output_folder=$(mktemp -d)
+
+for folder in "${folders[@]}"; do
+    for file in "${folder}"*.txt; do
+        name=$(basename "${file}" .txt)
+        echo -e "\e[1;37m""${file}""$(tput sgr0)"
+
+        ./projet --ticks "${ticks}" --out "${output_folder}/${name}-lee.txt" "${file}" \
+            > /dev/null
+        ./projet --ticks "${ticks}" --astar "${engines}" \
+            --out "${output_folder}/${name}-astar.txt" "${file}" > /dev/null
+        total=$((total + 1))
+
+        if ! [ -f "${output_folder}/${name}-lee.txt" ]; then
+            echo "./projet ${file} has no final state, skipped"
+            echo
+            total=$((total - 1))
+            continue
+        fi
+
+        if ! cmp -s "${output_folder}/${name}-lee.txt" \
+            "${output_folder}/${name}-astar.txt"; then
+            echo "./projet --ticks ${ticks} --astar ${engines} ${file}"
+
+            echo -e "\e[1;37m""Differences with the Lee algorithm":
+            echo -e "\e[1;31m"
+            diff "${output_folder}/${name}-lee.txt" "${output_folder}/${name}-astar.txt" \
+                | head -20
+            echo -e "\e[0;m"
+            echo
+
+            failed=$((failed + 1))
+        fi
+    done
+done
+
+rm -rf "${output_folder}"
+
+echo
+if (( failed > 0 )); then
+    echo -e "\e[1;31m""Failed: " "${failed} / ${total}"
+    exit 1
+else
+    echo -e "\e[1;32mFinished:" "${total} / ${total}"
+fi
@@ -0,0 +1,174 @@
+/**
+ * @file threadpool.cc
+ * @author Daniel Panero 100%, Andrea Diez 0%
+ * @version 0.1
+ * @date 2022-05-27
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(unsigned int n_threads) : ranges(std::max(n_threads, 1U))
+{
+    for (unsigned int i(1); i < ranges.size(); i++)
+    {
+        threads.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    job_started.notify_all();
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+unsigned int ThreadPool::get_n_threads() const { return ranges.size(); }
+
+void ThreadPool::run(size_t n_tasks, std::function<void(size_t)> const &task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->n_tasks = n_tasks;
+        failure = nullptr;
+
+        for (size_t i(0); i < ranges.size(); i++)
+        {
+            ranges[i].bounds = pack(n_tasks * i / ranges.size(),
+                                    n_tasks * (i + 1) / ranges.size());
+        }
+
+        job++;
+        n_threads_left = threads.size();
+    }
+    job_started.notify_all();
+
+    execute(0);
+
+    /* We wait for all the started threads, even the ones that came too late to take
+     * a task, so that none of them is still looking at this job when the next one is
+     * set up */
+    std::unique_lock<std::mutex> lock(mutex);
+    job_finished.wait(lock, [this] { return n_threads_left == 0; });
+    this->task = nullptr;
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+void ThreadPool::work(unsigned int index)
+{
+    unsigned long long last_job(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        job_started.wait(lock, [&] { return stop || job != last_job; });
+        if (stop)
+        {
+            return;
+        }
+        last_job = job;
+
+        lock.unlock();
+        execute(index);
+        lock.lock();
+
+        n_threads_left--;
+        if (n_threads_left == 0)
+        {
+            job_finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::execute(unsigned int index)
+{
+    size_t i(0);
+    while (pop(index, i) || (steal(index) && pop(index, i)))
+    {
+        try
+        {
+            (*task)(i);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure || i < failed_task)
+            {
+                failure = std::current_exception();
+                failed_task = i;
+            }
+        }
+    }
+}
+
+bool ThreadPool::pop(unsigned int index, size_t &task)
+{
+    auto &bounds = ranges[index].bounds;
+
+    uint64_t current = bounds.load();
+    while (true)
+    {
+        uint64_t begin = current & UINT32_MAX;
+        uint64_t end = current >> 32;
+        if (begin >= end)
+        {
+            return false;
+        }
+
+        if (bounds.compare_exchange_weak(current, pack(begin + 1, end)))
+        {
+            task = begin;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal(unsigned int index)
+{
+    for (size_t k(1); k < ranges.size(); k++)
+    {
+        auto &bounds = ranges[(index + k) % ranges.size()].bounds;
+
+        uint64_t current = bounds.load();
+        while (true)
+        {
+            uint64_t begin = current & UINT32_MAX;
+            uint64_t end = current >> 32;
+            if (begin >= end)
+            {
+                break;
+            }
+
+            uint64_t middle = end - (end - begin + 1) / 2;
+            if (bounds.compare_exchange_weak(current, pack(begin, middle)))
+            {
+                // Only the owner writes in its own range while it is empty
+                ranges[index].bounds = pack(middle, end);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file threadpool.h
+ * @author Daniel Panero, Andrea Diez
+ * @brief Fixed set of threads that run the independent tasks of a step of the
+ * simulation, balanced by work stealing
+ * @version 0.1
+ * @date 2022-05-27
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    /**
+     * @brief Creates a pool of @p n_threads threads, the thread calling \b run
+     * included: only n_threads - 1 threads are started
+     *
+     * @param n_threads at least 1
+     */
+    explicit ThreadPool(unsigned int n_threads);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool &operator=(ThreadPool const &) = delete;
+
+    unsigned int get_n_threads() const;
+
+    /**
+     * @brief Calls @p task (i) for each i in [0, @p n_tasks) and returns once they
+     * are all done. Each thread starts with a contiguous range of the tasks, which it
+     * runs in increasing order, and once it is done it steals the second half of the
+     * range of another thread, so the order in which the tasks run is not specified.
+     * If some tasks throw, the exception of the one with the lowest index is
+     * rethrown
+     *
+     * @param n_tasks
+     * @param task
+     */
+    void run(size_t n_tasks, std::function<void(size_t)> const &task);
+
+private:
+    /**
+     * @brief Loop of the started thread @p index: waits for a new job and takes part
+     * in it
+     *
+     */
+    void work(unsigned int index);
+
+    /**
+     * @brief Runs the tasks of the range of the thread @p index, then the ones
+     * stolen from the other threads, until there are none left
+     *
+     */
+    void execute(unsigned int index);
+
+    /**
+     * @brief Takes the first task of the range of the thread @p index
+     *
+     * @return false if the range is empty
+     */
+    bool pop(unsigned int index, size_t &task);
+
+    /**
+     * @brief Moves the second half of the range of another thread to the (empty)
+     * range of the thread @p index
+     *
+     * @return false if all the ranges are empty
+     */
+    bool steal(unsigned int index);
+
+    /**
+     * @brief Tasks [begin, end[ not taken yet of a thread, packed in one word
+     * (begin in the low 32 bits) so that the owner and the thieves can update them
+     * with a single compare-and-swap. Each range has its own cache line
+     *
+     */
+    struct alignas(64) Range
+    {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    static uint64_t pack(uint64_t begin, uint64_t end) { return begin | end << 32; }
+
+    std::vector<std::thread> threads;
+
+    // One per thread, the one of the thread calling run is the first
+    std::vector<Range> ranges;
+
+    std::mutex mutex;
+    std::condition_variable job_started;
+    std::condition_variable job_finished;
+
+    // Current job, only modified by run while no started thread takes part in a job
+    std::function<void(size_t)> const *task = nullptr;
+    size_t n_tasks = 0;
+
+    // Number of the job, each started thread takes part in every job exactly once
+    unsigned long long job = 0;
+    size_t n_threads_left = 0;
+    bool stop = false;
+
+    std::exception_ptr failure;
+    size_t failed_task = 0;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file triplebuffer.h
+ * @author Daniel Panero, Andrea Diez
+ * @brief Lock-free handoff of the latest value from one writer thread to one reader
+ * thread
+ * @version 0.1
+ * @date 2022-06-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Three buffers shared by a writer and a reader: the writer fills its buffer
+ * and publishes it, the reader takes the latest published buffer. Neither ever waits
+ * for the other (a single atomic exchange each), the values published while the
+ * reader didn't look are skipped, and the buffers are reused so that their memory
+ * (e.g: a vector) is allocated only once
+ *
+ * @tparam T
+ */
+template <typename T> class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(TripleBuffer const &) = delete;
+    TripleBuffer &operator=(TripleBuffer const &) = delete;
+
+    /**
+     * @brief Buffer of the writer, it can be modified until \b publish
+     *
+     */
+    T &get_write_buffer() { return buffers[back]; }
+
+    /**
+     * @brief Makes the buffer of the writer the latest value, and gives the writer
+     * the buffer which was waiting (the previous latest value or the one the reader
+     * released), whose content is stale
+     *
+     */
+    void publish()
+    {
+        back = middle.exchange(back | fresh, std::memory_order_acq_rel) & index_mask;
+    }
+
+    /**
+     * @brief Takes the latest published value, if there is a new one
+     *
+     * @return true if the buffer of the reader changed
+     */
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & fresh))
+        {
+            return false;
+        }
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+        return true;
+    }
+
+    /**
+     * @brief Buffer of the reader: the latest value taken by \b update, it doesn't
+     * change until the next one
+     *
+     */
+    T const &get_read_buffer() const { return buffers[front]; }
+
+private:
+    // The index of the buffer in the middle and a bit telling if it was never read
+    static constexpr uint8_t index_mask = 3;
+    static constexpr uint8_t fresh = 4;
+
+    T buffers[3];
+
+    // Only used by the writer
+    uint8_t back = 0;
+
+    // Only exchanged atomically, it hands over the buffers
+    std::atomic<uint8_t> middle{1};
+
+    // Only used by the reader
+    uint8_t front = 2;
+};
+
+#endif